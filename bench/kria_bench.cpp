@@ -0,0 +1,245 @@
+// Headless end-to-end benchmark of the client: runs the real MainWindow
+// (video widget, radar overlay, controls) on the offscreen QPA platform
+// against a synthetic or recorded capture source and reports throughput,
+// capture-to-paint latency, drops, CPU and memory use as JSON.
+//
+//   kria_bench [--url synthetic://1920x1080@60] [--size 1280x800]
+//              [--warmup 2] [--duration 10] [--rotation 180] [--output file.json]
+
+#include "mainwindow.h"
+#include "videokernel.h"
+#include "processusage.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+double percentile(const std::vector<qint64> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)] / 1e6;
+}
+
+QSize parseSize(const QString &text)
+{
+    QStringList parts = text.split('x');
+    if (parts.size() != 2)
+        return QSize();
+    return QSize(parts[0].toInt(), parts[1].toInt());
+}
+
+} // namespace
+
+class PipelineBenchmark : public QObject
+{
+public:
+    PipelineBenchmark(MainWindow *window, int warmupMs, int durationMs)
+        : m_window(window), m_warmupMs(warmupMs), m_durationMs(durationMs)
+    {
+        // Enough for 1000 fps, so recording never allocates
+        m_latenciesNs.reserve(static_cast<size_t>(durationMs) + 1024);
+        connect(window, &MainWindow::framePainted, this, [this](quint64, const FrameTimestamps &timestamps) {
+            onFramePainted(timestamps);
+        });
+    }
+
+    bool finished() const { return m_phase == Done; }
+
+    QJsonObject results() const
+    {
+        std::vector<qint64> sorted = m_latenciesNs;
+        std::sort(sorted.begin(), sorted.end());
+
+        double seconds = m_measureTimeNs / 1e9;
+        quint64 painted = static_cast<quint64>(m_latenciesNs.size());
+        quint64 grabbed = m_endStats.framesGrabbed - m_startStats.framesGrabbed;
+        double cpuSeconds = m_endUsage.cpuSeconds - m_startUsage.cpuSeconds;
+
+        QJsonObject frames;
+        frames["grabbed"] = static_cast<qint64>(grabbed);
+        frames["retrieved"] = static_cast<qint64>(m_endStats.framesRetrieved - m_startStats.framesRetrieved);
+        frames["converted"] = static_cast<qint64>(m_endStats.framesConverted - m_startStats.framesConverted);
+        frames["painted"] = static_cast<qint64>(painted);
+        frames["dropped"] = static_cast<qint64>(grabbed > painted ? grabbed - painted : 0);
+
+        QJsonObject latency;
+        latency["min"] = percentile(sorted, 0.0);
+        latency["p50"] = percentile(sorted, 0.50);
+        latency["p90"] = percentile(sorted, 0.90);
+        latency["p99"] = percentile(sorted, 0.99);
+        latency["max"] = percentile(sorted, 1.0);
+
+        QJsonObject result;
+        result["duration_s"] = seconds;
+        result["fps"] = seconds > 0 ? painted / seconds : 0.0;
+        result["capture_fps"] = seconds > 0 ? grabbed / seconds : 0.0;
+        result["frames"] = frames;
+        result["latency_ms"] = latency;
+        result["stage_latency_ms"] = m_stages;
+        result["cpu_ms_per_frame"] = painted > 0 ? cpuSeconds * 1000.0 / painted : 0.0;
+        result["cpu_utilization"] = seconds > 0 ? cpuSeconds / seconds : 0.0;
+        result["peak_rss_kb"] = m_endUsage.peakResidentBytes / 1024;
+        return result;
+    }
+
+private:
+    enum Phase {
+        WaitingForFirstFrame,
+        Warmup,
+        Measuring,
+        Done
+    };
+
+    MainWindow *m_window;
+    int m_warmupMs;
+    int m_durationMs;
+    Phase m_phase = WaitingForFirstFrame;
+    QElapsedTimer m_phaseTimer;
+    qint64 m_measureTimeNs = 0;
+    std::vector<qint64> m_latenciesNs;
+    StreamStats m_startStats;
+    StreamStats m_endStats;
+    ProcessUsage m_startUsage;
+    ProcessUsage m_endUsage;
+    QJsonObject m_stages;
+
+    // Per-stage breakdown from the pipeline's own histograms
+    QJsonObject stageLatencies() const
+    {
+        QJsonObject stages;
+        const PipelineLatency &latency = m_window->pipelineLatency();
+        for (int i = 0; i < PipelineLatency::StageCount; ++i) {
+            PipelineLatency::Stage stage = static_cast<PipelineLatency::Stage>(i);
+            LatencyHistogram::Summary s = latency.histogram(stage).summary();
+            QJsonObject entry;
+            entry["count"] = static_cast<qint64>(s.count);
+            entry["mean"] = s.mean / 1e6;
+            entry["p50"] = s.p50 / 1e6;
+            entry["p99"] = s.p99 / 1e6;
+            entry["p999"] = s.p999 / 1e6;
+            entry["max"] = s.max / 1e6;
+            stages[PipelineLatency::stageName(stage)] = entry;
+        }
+        return stages;
+    }
+
+    void onFramePainted(const FrameTimestamps &timestamps)
+    {
+        switch (m_phase) {
+        case WaitingForFirstFrame:
+            m_phase = Warmup;
+            m_phaseTimer.start();
+            return;
+        case Warmup:
+            if (m_phaseTimer.elapsed() < m_warmupMs)
+                return;
+            m_phase = Measuring;
+            m_startStats = m_window->streamStats();
+            m_startUsage = ProcessUsage::current();
+            m_window->pipelineLatency().reset();
+            m_phaseTimer.start();
+            return;
+        case Measuring:
+            m_latenciesNs.push_back(timestamps.painted - timestamps.grabbed);
+            if (m_phaseTimer.elapsed() < m_durationMs)
+                return;
+            m_measureTimeNs = m_phaseTimer.nsecsElapsed();
+            m_endStats = m_window->streamStats();
+            m_endUsage = ProcessUsage::current();
+            m_stages = stageLatencies();
+            m_phase = Done;
+            QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+            return;
+        case Done:
+            return;
+        }
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // Render without a display unless a platform was asked for explicitly
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("kria_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless capture-to-paint pipeline benchmark");
+    parser.addHelpOption();
+    QCommandLineOption urlOption("url", "Capture source URL.", "url", "synthetic://1920x1080@60");
+    QCommandLineOption sizeOption("size", "Window size.", "WxH", "1280x800");
+    QCommandLineOption warmupOption("warmup", "Warm-up time in seconds.", "seconds", "2");
+    QCommandLineOption durationOption("duration", "Measurement time in seconds.", "seconds", "10");
+    QCommandLineOption rotationOption("rotation", "Display rotation (0 or 180).", "degrees", "180");
+    QCommandLineOption outputOption("output", "Write the JSON report to a file instead of stdout.", "file");
+    parser.addOptions({urlOption, sizeOption, warmupOption, durationOption, rotationOption, outputOption});
+    parser.process(app);
+
+    QSize windowSize = parseSize(parser.value(sizeOption));
+    if (windowSize.isEmpty()) {
+        qCritical() << "Invalid window size:" << parser.value(sizeOption);
+        return 2;
+    }
+    int warmupMs = static_cast<int>(parser.value(warmupOption).toDouble() * 1000);
+    int durationMs = static_cast<int>(parser.value(durationOption).toDouble() * 1000);
+
+    MainWindow window;
+    window.setStreamUrl(parser.value(urlOption));
+    window.setDisplayOrientation(parser.value(rotationOption).toInt(), 1.6);
+    window.resize(windowSize);
+    window.show();
+
+    PipelineBenchmark benchmark(&window, warmupMs, durationMs);
+
+    // Give up if the source never delivers a frame
+    QTimer::singleShot(warmupMs + durationMs + 15000, &app, [&app]() {
+        qCritical() << "Benchmark timed out";
+        app.exit(1);
+    });
+
+    int status = app.exec();
+    if (status != 0 || !benchmark.finished())
+        return status != 0 ? status : 1;
+
+    QJsonObject report = benchmark.results();
+    QJsonObject config;
+    config["url"] = parser.value(urlOption);
+    config["window"] = parser.value(sizeOption);
+    config["rotation"] = parser.value(rotationOption).toInt();
+    config["kernel"] = QString::fromLatin1(VideoKernel::backendName());
+    config["cpu"] = QSysInfo::currentCpuArchitecture();
+    config["qt"] = QString::fromLatin1(qVersion());
+#ifdef OPENCV_ENABLED
+    config["opencv"] = true;
+#else
+    config["opencv"] = false;
+#endif
+    report["config"] = config;
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Cannot write" << file.fileName();
+            return 1;
+        }
+        file.write(json);
+    } else {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+// Microbenchmarks (Google Benchmark) of the code that runs for every video
+// frame or every input event. Widgets render offscreen.
+//
+//   kria_microbench [--benchmark_filter=...] [--benchmark_format=json]
+
+#include "displaymapping.h"
+#include "distancemap.h"
+#include "nativecontroller.h"
+#include "videokernel.h"
+#include "videowidget.h"
+#include <QApplication>
+#include <QRandomGenerator>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// Source frame with a deterministic, non-uniform pattern
+std::vector<uchar> makeFrame(int width, int height, int channels)
+{
+    std::vector<uchar> pixels(static_cast<size_t>(width) * height * channels);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uchar>((i * 7) ^ (i >> 9));
+    return pixels;
+}
+
+// Message handler that drops everything: the command benchmarks include
+// building the log messages but not writing them to the terminal
+void discardMessages(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+// The vector kernels must match the scalar reference pixel for pixel before
+// their timings mean anything
+bool verifyVideoKernel()
+{
+    struct Case { int srcW, srcH, dstW, dstH; };
+    const Case cases[] = {
+        {1920, 1080, 1920, 1080}, {1920, 1080, 1280, 720}, {1280, 720, 1920, 1080},
+        {641, 359, 1280, 800}, {3840, 2160, 1280, 800}, {17, 9, 33, 5}
+    };
+
+    for (const Case &c : cases) {
+        for (int channels : {3, 1}) {
+            for (bool rotate : {false, true}) {
+                std::vector<uchar> pixels = makeFrame(c.srcW, c.srcH, channels);
+                VideoKernel::Source src = { pixels.data(), c.srcW, c.srcH, c.srcW * channels,
+                                            channels == 3 ? VideoKernel::Bgr24 : VideoKernel::Gray8 };
+                std::vector<uchar> expected(static_cast<size_t>(c.dstW) * c.dstH * 4);
+                std::vector<uchar> actual(expected.size());
+                VideoKernel::convertScaleRotateReference(src, { expected.data(), c.dstW, c.dstH, c.dstW * 4 }, rotate);
+                VideoKernel::convertScaleRotate(src, { actual.data(), c.dstW, c.dstH, c.dstW * 4 }, rotate);
+                if (expected != actual) {
+                    fprintf(stderr, "VideoKernel (%s) differs from the reference: %dx%d -> %dx%d, %d channel(s), rotate %d\n",
+                            VideoKernel::backendName(), c.srcW, c.srcH, c.dstW, c.dstH, channels, rotate);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Capture thread conversion: args are source width, height, channels and
+// whether the frame is scaled and rotated to a 1280x800 display (1) or only
+// converted at source size (0)
+static void BM_FrameToQImage(benchmark::State &state)
+{
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+    const bool display = state.range(3) != 0;
+
+    std::vector<uchar> pixels = makeFrame(width, height, channels);
+    CaptureFrame frame;
+    frame.data = pixels.data();
+    frame.width = width;
+    frame.height = height;
+    frame.stride = width * channels;
+    frame.channels = channels;
+
+    FramePool pool;
+    const QSize displaySize = display ? QSize(1280, 800) : QSize();
+
+    for (auto _ : state) {
+        QImage image = frameToQImage(frame, displaySize, display, pool);
+        benchmark::DoNotOptimize(image.constBits());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(pixels.size()));
+}
+BENCHMARK(BM_FrameToQImage)
+    ->ArgNames({"w", "h", "ch", "display"})
+    ->ArgsProduct({{1280}, {720}, {3, 1}, {0, 1}})
+    ->ArgsProduct({{1920}, {1080}, {3, 1}, {0, 1}})
+    ->ArgsProduct({{3840}, {2160}, {3, 1}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// GUI side of MainWindow::updateFrame(): hand a frame to the video widget
+// and paint it. Arg 0 is a display-sized frame (plain blit), arg 1 a
+// 1920x1080 frame the widget has to scale.
+static void BM_VideoWidgetPaint(benchmark::State &state)
+{
+    const QSize widgetSize(1280, 800);
+    const QSize frameSize = state.range(0) ? QSize(1920, 1080) : widgetSize;
+
+    VideoWidget widget;
+    widget.resize(widgetSize);
+    widget.show();
+
+    // Two frames, so setFrame() never skips a repeat
+    QImage frames[2] = { QImage(frameSize, QImage::Format_RGB32), QImage(frameSize, QImage::Format_RGB32) };
+    frames[0].fill(Qt::darkGreen);
+    frames[1].fill(Qt::darkBlue);
+    QImage target(widgetSize, QImage::Format_RGB32);
+
+    int index = 0;
+    for (auto _ : state) {
+        widget.setFrame(frames[index]);
+        widget.render(&target);
+        index ^= 1;
+    }
+    benchmark::DoNotOptimize(target.constBits());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VideoWidgetPaint)->ArgName("scaled")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// A 1920x1080 stream letterboxed in a 1280x800 window
+static void BM_NormalizeCoordinates(benchmark::State &state)
+{
+    const QRect videoRect(0, 0, 1280, 800);
+    const QSize frameSize(1920, 1080);
+    int x = 0;
+    for (auto _ : state) {
+        QPointF point = normalizeCoordinates(QPoint(x, 400), videoRect, frameSize);
+        benchmark::DoNotOptimize(point);
+        x = (x + 7) % 1280;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NormalizeCoordinates);
+
+static void BM_RadarToWidget(benchmark::State &state)
+{
+    const QSizeF viewSize(320, 320);
+    float angle = 0.0f;
+    for (auto _ : state) {
+        QPointF point = radarToWidget(5.0f, angle, viewSize, 10.0f);
+        benchmark::DoNotOptimize(point);
+        angle = angle < 180.0f ? angle + 0.5f : 0.0f;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RadarToWidget);
+
+// Full radar repaint with the given number of points
+static void BM_DistanceMapPaint(benchmark::State &state)
+{
+    DistanceMap map;
+    map.setFixedSize(320, 320);
+    map.setMapSize(15, 15);
+
+    QRandomGenerator random(42);
+    for (int64_t i = 0; i < state.range(0); ++i)
+        map.addRadarPoint(0.5f + random.bounded(9.5), static_cast<float>(random.bounded(180.0)), Qt::red);
+
+    QImage target(map.size(), QImage::Format_ARGB32_Premultiplied);
+    for (auto _ : state) {
+        target.fill(Qt::transparent);
+        map.render(&target);
+    }
+    benchmark::DoNotOptimize(target.constBits());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DistanceMapPaint)->ArgName("points")->Arg(10)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Controller commands: the cost on the calling (GUI) thread, which only
+// queues them for the link thread. Every LinkDrainInterval commands the
+// timer pauses until the link has sent them, so the 256-entry queue never
+// overflows and each command measured is one that goes out. Arg 1 has the
+// link send them over UDP to a local port nobody listens on, arg 0 has it
+// encode and drop them with UDP disabled.
+static const int LinkDrainInterval = 64;
+
+template <typename Send>
+static void runCommandBenchmark(benchmark::State &state, Send send)
+{
+    NativeController controller;
+    controller.setServerAddress("127.0.0.1");
+    controller.setUdpPort(18556);
+    controller.enableUdpClient(state.range(0) != 0);
+    controller.waitForLink();
+
+    int pending = 0;
+    for (auto _ : state) {
+        send(controller);
+        if (++pending == LinkDrainInterval) {
+            state.PauseTiming();
+            controller.waitForLink();
+            pending = 0;
+            state.ResumeTiming();
+        }
+    }
+    controller.waitForLink();
+
+    if (controller.stats().queueOverflows != 0)
+        state.SkipWithError("Control link queue overflowed");
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SendButtonPress(benchmark::State &state)
+{
+    runCommandBenchmark(state, [](NativeController &controller) {
+        controller.sendButtonPress("UP");
+    });
+}
+BENCHMARK(BM_SendButtonPress)->ArgName("udp")->Arg(0)->Arg(1);
+
+static void BM_SendTouchCoordinate(benchmark::State &state)
+{
+    int x = 0;
+    runCommandBenchmark(state, [&x](NativeController &controller) {
+        controller.sendTouchCoordinate(x, 540);
+        x = (x + 13) % 1920;
+    });
+}
+BENCHMARK(BM_SendTouchCoordinate)->ArgName("udp")->Arg(0)->Arg(1);
+
+static void BM_SendModeChange(benchmark::State &state)
+{
+    bool autoMode = false;
+    runCommandBenchmark(state, [&autoMode](NativeController &controller) {
+        controller.sendModeChange(autoMode);
+        autoMode = !autoMode;
+    });
+}
+BENCHMARK(BM_SendModeChange)->ArgName("udp")->Arg(0)->Arg(1);
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    if (!verifyVideoKernel())
+        return 1;
+
+    // The application's handler (AsyncLogger) is installed by main.cpp
+    qInstallMessageHandler(discardMessages);
+
+    benchmark::AddCustomContext("video_kernel", VideoKernel::backendName());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
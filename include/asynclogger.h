@@ -0,0 +1,38 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QtGlobal>
+#include <QString>
+
+// Qt message handler that keeps formatting and I/O off the calling thread.
+// A message is copied into a preallocated ring of fixed-size records (a
+// BoundedQueue: lock-free, no allocation, no locks); a background
+// thread adds the timestamp text, formats the line and writes it to stderr
+// in batches. When the ring is full new records are dropped and counted,
+// so a logging storm can never block the GUI or capture threads.
+//
+// Level filtering happens before a message is even built: qCDebug()/qCInfo()
+// check the category first, so disabled categories cost a single branch
+// (runtime: setMinimumLevel() or QT_LOGGING_RULES; compile time: the
+// KRIA_MIN_LOG_LEVEL CMake option defines QT_NO_DEBUG_OUTPUT/QT_NO_INFO_OUTPUT).
+class AsyncLogger
+{
+public:
+    // Records in the ring (a BoundedQueue)
+    static const size_t Capacity = 4096;
+
+    // Installs the handler and starts the writer thread
+    static void install();
+
+    // Writes what is still queued and restores Qt's default handler. Call
+    // once the threads that log have stopped.
+    static void shutdown();
+
+    // Runtime filter for all categories: "debug", "info", "warning" or "critical"
+    static bool setMinimumLevel(const QString &level);
+
+    static quint64 writtenRecords();
+    static quint64 droppedRecords();
+};
+
+#endif // ASYNCLOGGER_H
@@ -0,0 +1,92 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for many producers and one consumer (Vyukov's
+// array queue). Every slot carries a sequence number that tells whether it
+// is free for the producer of a given turn or holds an item for the
+// consumer, so push() and pop() never lock, allocate or wait on each other.
+// A full queue makes push() fail instead of blocking. emplace() and
+// consume() work on the slot in place, for items too big to copy around.
+//
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class BoundedQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    BoundedQueue() : m_enqueuePos(0), m_dequeuePos(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. Returns false if the queue is full.
+    bool push(const T &item)
+    {
+        return emplace([&item](T &slot) { slot = item; });
+    }
+
+    // Consumer thread only. Returns false if nothing is queued.
+    bool pop(T &item)
+    {
+        return consume([&item](const T &slot) { item = slot; });
+    }
+
+    // Any thread. Calls fill(T &) to write the item straight into its slot;
+    // returns false, without calling it, if the queue is full.
+    template <typename Fill>
+    bool emplace(Fill fill)
+    {
+        size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & (Capacity - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->item);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Calls consume(const T &) on the oldest item,
+    // which is released afterwards; returns false if nothing is queued.
+    template <typename Consume>
+    bool consume(Consume consume)
+    {
+        Cell &cell = m_cells[m_dequeuePos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+            return false;
+
+        consume(static_cast<const T &>(cell.item));
+        cell.sequence.store(m_dequeuePos + Capacity, std::memory_order_release);
+        ++m_dequeuePos;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    Cell m_cells[Capacity];
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) size_t m_dequeuePos;
+};
+
+#endif // BOUNDEDQUEUE_H
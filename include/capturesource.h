@@ -0,0 +1,43 @@
+#ifndef CAPTURESOURCE_H
+#define CAPTURESOURCE_H
+
+#include <QSize>
+#include <QString>
+#include <memory>
+
+// Pixel data of one captured frame. Points into memory owned by the
+// source and is only valid until the next grab().
+struct CaptureFrame {
+    const uchar *data = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;     // Bytes per row
+    int channels = 3;   // 3 = BGR24, 1 = Gray8
+
+    bool isNull() const { return data == nullptr; }
+};
+
+// Where RTSPStreamer gets its frames from. grab() and retrieve() follow the
+// cv::VideoCapture split: grab() advances to the next frame as cheaply as
+// possible, retrieve() produces its pixels.
+class CaptureSource
+{
+public:
+    virtual ~CaptureSource() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool grab() = 0;
+    virtual bool retrieve(CaptureFrame &frame) = 0;
+    virtual QSize frameSize() const = 0;
+
+    // Picks the backend from the URL scheme:
+    //   synthetic://WIDTHxHEIGHT@FPS[/PATTERN]   generated frames (see SyntheticSource)
+    //   file:///path/to/recording                 video file or .kraw frame dump replay
+    //   anything else (rtsp://, http://, ...)     OpenCV VideoCapture
+    // Returns nullptr if the URL needs a backend that wasn't compiled in.
+    static std::unique_ptr<CaptureSource> create(const QString &url);
+    static bool supportsUrl(const QString &url);
+};
+
+#endif // CAPTURESOURCE_H
@@ -0,0 +1,92 @@
+#ifndef COMMANDTRACKER_H
+#define COMMANDTRACKER_H
+
+#include <QtGlobal>
+#include "controlprotocol.h"
+#include "latencyhistogram.h"
+
+// Bookkeeping for commands sent over UDP until the server acknowledges
+// them. Matches ACKs to in-flight commands, records the round-trip time and
+// decides when a reliable command is due to be sent again.
+//
+// Reliable (state-changing) commands are resent with exponential backoff,
+// starting at twice the smoothed RTT, until acknowledged or MaxAttempts is
+// reached. Any newer command of the same type supersedes an older
+// unacknowledged one. Fire-and-forget commands are never resent; they only
+// feed the RTT and loss statistics and count as lost after LossTimeoutNs.
+//
+// Commands are copied into a fixed table, so tracking does not allocate.
+// Not thread-safe: owned by the thread that sends and receives.
+class CommandTracker
+{
+public:
+    static const int Capacity = 64;
+    static const int MaxCommandSize = 64;
+    static const int MaxAttempts = 6;
+    static const qint64 InitialRetransmitNs = 100000000;  // Before any RTT sample
+    static const qint64 MinRetransmitNs = 20000000;
+    static const qint64 MaxRetransmitNs = 2000000000;     // Backoff ceiling
+    static const qint64 LossTimeoutNs = 2000000000;
+
+    struct Command {
+        bool active = false;
+        bool reliable = false;
+        ControlProtocol::MessageType type = ControlProtocol::ButtonMessage;
+        quint32 sequence = 0;
+        int attempts = 0;
+        qint64 lastSentNs = 0;
+        qint64 deadlineNs = 0;  // Next retransmission, or when it counts as lost
+        int size = 0;
+        char data[MaxCommandSize];
+    };
+
+    CommandTracker();
+
+    // Starts tracking a command that has just been sent for the first time.
+    // Commands larger than MaxCommandSize are not tracked.
+    void sent(ControlProtocol::MessageType type, quint32 sequence, const char *data, int size,
+              bool reliable, qint64 nowNs);
+
+    // Binary ACK: matched by sequence number; the echoed send time gives the
+    // RTT even for retransmitted commands. Returns the RTT or -1 if unknown.
+    qint64 acknowledged(quint32 sequence, qint64 echoedSentNs, qint64 nowNs);
+    // Text ACK ("ACK:<command>" with the prefix removed): matched to the
+    // oldest identical command. Retransmitted commands yield no RTT sample,
+    // as it isn't known which copy was acknowledged.
+    qint64 acknowledged(const char *command, int size, qint64 nowNs);
+
+    // The next reliable command due to be resent, with its attempt count and
+    // deadline already advanced, or nullptr. Overdue commands that have run
+    // out of attempts (or aren't resent at all) are dropped as lost first.
+    Command *nextRetransmission(qint64 nowNs);
+
+    // Earliest deadline of any tracked command, or 0 if none
+    qint64 nextDeadlineNs() const;
+
+    const LatencyHistogram &roundTripTime() const { return m_rtt; }
+    qint64 smoothedRttNs() const { return m_smoothedRttNs; }
+    // Moving average of the fraction of transmissions not acknowledged
+    double lossRate() const { return m_lossRate; }
+
+    quint64 acks() const { return m_acks; }
+    quint64 lost() const { return m_lost; }
+    quint64 retransmissions() const { return m_retransmissions; }
+    // Reliable commands given up on after MaxAttempts
+    quint64 failed() const { return m_failed; }
+
+private:
+    Command m_commands[Capacity];
+    LatencyHistogram m_rtt;
+    qint64 m_smoothedRttNs = 0;
+    double m_lossRate = 0.0;
+    quint64 m_acks = 0;
+    quint64 m_lost = 0;
+    quint64 m_retransmissions = 0;
+    quint64 m_failed = 0;
+
+    qint64 retransmitTimeoutNs(int attempts) const;
+    void resolve(Command &command, qint64 rttNs);
+    void recordOutcome(bool lost);
+};
+
+#endif // COMMANDTRACKER_H
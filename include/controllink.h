@@ -0,0 +1,312 @@
+#ifndef CONTROLLINK_H
+#define CONTROLLINK_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QHostAddress>
+#include <atomic>
+#include "boundedqueue.h"
+#include "controlprotocol.h"
+#include "commandtracker.h"
+#include "radarscan.h"
+#include "triplebuffer.h"
+
+// Commands and traffic sent to the server
+struct ControllerStats {
+    quint64 buttonCommands = 0;
+    quint64 touchCommands = 0;
+    quint64 modeCommands = 0;
+    quint64 stateCommands = 0;  // Input state samples (ticks and edges)
+    quint64 stopCommands = 0;   // Emergency stops
+    quint64 preemptedCommands = 0; // Queued motion dropped by an emergency stop
+    quint64 udpBytesSent = 0;
+    quint64 tcpBytesSent = 0;
+    quint64 sendErrors = 0;
+    quint64 tcpReconnects = 0;  // Reconnect attempts after losing the server
+    quint64 acksReceived = 0;   // UDP commands acknowledged by the server
+    quint64 commandsLost = 0;   // UDP commands never acknowledged
+    quint64 retransmissions = 0;
+    quint64 queueOverflows = 0; // Commands dropped because the link queue was full
+    quint64 batches = 0;        // Datagrams/TCP writes carrying more than one command
+    quint64 batchedCommands = 0; // Commands sent in those
+    quint64 tcpQueueDepth = 0;  // Commands waiting for the TCP connection
+    quint64 tcpQueueDropped = 0; // Superseded, stale or overflowing queued TCP commands
+    quint64 tcpReplayed = 0;    // Queued TCP commands sent after reconnecting
+    qint64 tcpReconnectNs = 0;  // Duration of the last TCP outage
+    quint64 scansReceived = 0;  // Telemetry scans from the server
+    quint64 scansMalformed = 0;
+    qint64 smoothedRttNs = 0;
+    double lossRate = 0.0;      // Recent fraction of unacknowledged datagrams
+};
+
+// A command on its way from the input handlers to the link thread
+struct ControlCommand {
+    ControlProtocol::MessageType type = ControlProtocol::ButtonMessage;
+    qint32 x = 0;
+    qint32 y = 0;
+    bool autoMode = false;
+    char button[16] = {};  // Latin-1 button name, for text BUTTON: commands
+    quint8 directions = 0; // State: held InputSampler::Direction bits
+    qint16 axisX = 0;      // State: stick position
+    qint16 axisY = 0;
+    bool edge = false;     // State: press/release rather than a tick
+    qint64 queuedNs = 0;   // MonotonicClock::timestampNs() when queued
+    quint32 group = 0;     // NativeController::Batch it was posted in, 0 if none
+};
+
+// The network side of NativeController: owns the UDP and TCP sockets,
+// encodes commands and handles ACKs, retransmission and reconnects. It
+// lives on its own thread with its own event loop, so a command goes out as
+// soon as it is posted instead of waiting behind frame and radar paints on
+// the GUI thread.
+//
+// Commands that are pending together go out together: one datagram and one
+// TCP write with a batch header (see ControlProtocol), while a lone command
+// is sent exactly as without batching. A batch is flushed once the queue is
+// empty, or up to the batch latency later to collect commands posted in
+// the meantime. Reliable commands (mode changes, input edges) flush
+// immediately.
+//
+// Commands are scheduled by priority class (see Priority): each drain sends
+// the higher classes first, except that the commands of one
+// NativeController::Batch stay in posting order. The TCP queue is kept in
+// class order and drops from the lowest class when full. An emergency stop
+// bypasses the queues and batching altogether: it goes out at the next
+// wake-up over each enabled transport, is retransmitted over UDP until
+// acknowledged on either, and drops queued motion commands and moving
+// input state that would otherwise follow it.
+//
+// TCP commands that cannot be written, because the connection is down or
+// Qt's send buffer is backed up, wait in a bounded queue. Only the newest
+// MODE and STATE matter, so older ones are dropped from it; after a
+// reconnect these are replayed and queued one-shot motion commands, stale
+// by then, are dropped. Reconnects back off exponentially with jitter.
+//
+// The link also receives the server's telemetry: Scan messages arriving on
+// the command socket, the telemetry port or the TCP connection are decoded
+// here into a triple buffer, and scanReady() tells the GUI thread to pick
+// up the newest one with takeScan(). Scans it doesn't get to are skipped.
+//
+// post(), wake(), emergencyStop() and takeScan() are the only calls meant
+// for other threads; they are lock-free. All other methods must run on the
+// link thread (NativeController invokes them there). Stats and the
+// histograms can be read from any thread.
+class ControlLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const size_t QueueCapacity = 256;
+    static const int MaxBatchBytes = 1200;   // Fits one datagram on a 1500 byte MTU
+    static const int MaxBatchCommands = 32;
+    static const int TcpQueueCapacity = 64;
+    static const int MaxTcpCommandSize = 64;
+    static const qint64 TcpHighWaterBytes = 1024;   // Unwritten bytes in Qt's buffer before queuing
+    static const int TcpSendBufferBytes = 8192;      // Kernel send buffer
+    static const int ReconnectInitialMs = 250;
+    static const int ReconnectMaxMs = 8000;
+    static const int MaxDatagramSize = 2048;
+    static const int TcpReadBufferSize = 4096;
+
+    // Scheduling classes, highest first
+    enum Priority {
+        EmergencyPriority,  // STOP
+        StatePriority,      // Mode changes and input state
+        MotionPriority,     // Directional buttons and touch targets
+        TelemetryPriority,  // Telemetry and diagnostics
+        PriorityCount
+    };
+
+    explicit ControlLink(QObject *parent = nullptr);
+
+    static Priority priority(ControlProtocol::MessageType type);
+
+    // Queues a command for sending; false if the queue is full. With wake
+    // false the link isn't woken up, so further commands can be posted to
+    // go out in the same batch; wake() sends them.
+    bool post(const ControlCommand &command, bool wake = true);
+    void wake();
+
+    // Sends STOP ahead of everything else; motion commands queued before it
+    // are dropped
+    void emergencyStop();
+
+    // Newest scan since the last call, or nullptr. The scan stays valid
+    // until the next call. GUI thread (one consumer) only.
+    const RadarScan *takeScan();
+
+    // Link thread only
+    void start();
+    void stop();
+    void setServerAddress(const QString &address);
+    void setUdpPort(quint16 port);
+    void setTcpPort(quint16 port);
+    // Local UDP port to receive telemetry on, besides the command socket;
+    // 0 (default) doesn't open one
+    void setTelemetryPort(quint16 port);
+    void setUdpEnabled(bool enabled);
+    void setTcpEnabled(bool enabled);
+    void setProtocolFormat(ControlProtocol::Format format);
+    // How long a batch may wait for more commands before it is sent:
+    // 0 (default) sends what is pending at once, negative disables batching
+    void setBatchLatency(int ms);
+    // SCHED_FIFO on Linux (needs CAP_SYS_NICE), highest Qt priority elsewhere
+    void setRealtimePriority(bool enabled);
+
+    // Spell out every sent command in commandSent(); costs an allocation
+    // per command, so only on while somebody listens. Any thread.
+    void setReportCommands(bool enabled);
+
+    // Any thread
+    void fillStats(ControllerStats &stats) const;
+    const LatencyHistogram &roundTripTime() const { return m_tracker.roundTripTime(); }
+    // From queuing a command to handing it to the socket
+    const LatencyHistogram &inputToWire() const { return m_inputToWire; }
+
+signals:
+    void serverConnected();
+    void serverDisconnected();
+    void commandSent(const QString &command);
+    void errorOccurred(const QString &error);
+    void roundTripTimeMeasured(double rttMs);
+    void linkQualityChanged(double smoothedRttMs, double lossRate);
+    // rttMs is -1 if unknown (text STOP acknowledged after a retransmission)
+    void emergencyStopAcknowledged(double rttMs);
+    // A scan is waiting in takeScan(); not emitted again until it is taken
+    void scanReady();
+
+private slots:
+    void drain();
+    void onTcpConnected();
+    void onTcpDisconnected();
+    void onTcpError(QAbstractSocket::SocketError error);
+    void onTcpBytesWritten(qint64 bytes);
+    void reconnectToServer();
+    void onUdpReadyRead();
+    void onTcpReadyRead();
+    void onRetransmitTimeout();
+    void flushBatch();
+
+private:
+    BoundedQueue<ControlCommand, QueueCapacity> m_queue;
+    std::atomic<bool> m_drainPending;
+    std::atomic<bool> m_reportCommands;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<qint64> m_stopRequestedNs;
+    ControlCommand m_drained[QueueCapacity];  // One drain
+    quint8 m_drainedClass[QueueCapacity];     // Their Priority, batches at their highest
+
+    QUdpSocket *m_udpSocket;
+    QUdpSocket *m_telemetrySocket;
+    QTcpSocket *m_tcpClient;
+    QTimer *m_reconnectTimer;
+    QTimer *m_retransmitTimer;
+    QTimer *m_flushTimer;
+
+    // Settings (link thread)
+    QString m_serverAddress;
+    QHostAddress m_serverHost;
+    quint16 m_udpPort;
+    quint16 m_tcpPort;
+    quint16 m_telemetryPort;
+    bool m_udpEnabled;
+    bool m_tcpEnabled;
+    bool m_autoReconnect;
+    ControlProtocol::Format m_protocolFormat;
+    ControlProtocol m_protocol;  // Reusable binary message buffer
+    CommandTracker m_tracker;    // UDP commands awaiting an ACK
+    quint32 m_textSequence;      // Tracking id for text commands
+    quint32 m_stopSequence;      // Tracking id of the last STOP
+    bool m_stopUnacknowledged;
+
+    // Commands of the next batch, stored from BatchReserve on so the batch
+    // header can be written in front of them
+    struct BatchEntry {
+        int offset;
+        int size;              // Without the newline of text commands
+        quint32 sequence;
+        ControlProtocol::MessageType type;
+        bool reliable;
+        bool motion;
+        qint64 queuedNs;
+    };
+    static const int BatchReserve = ControlProtocol::BatchHeaderSize;
+    char m_batch[BatchReserve + MaxBatchBytes];
+    int m_batchSize;
+    BatchEntry m_batchEntries[MaxBatchCommands];
+    int m_batchCount;
+    qint64 m_batchLatencyNs;
+
+    // Commands waiting for TCP, oldest first
+    struct TcpPending {
+        char data[MaxTcpCommandSize];
+        int size;
+        ControlProtocol::MessageType type;
+        bool binary;
+        bool motion;           // Dropped by an emergency stop
+    };
+    TcpPending m_tcpQueue[TcpQueueCapacity];
+    int m_tcpQueueCount;
+    int m_reconnectAttempts;
+    qint64 m_tcpDownSinceNs;     // When the connection went down, 0 while up
+
+    // Received from the server, not yet parsed
+    char m_tcpRead[TcpReadBufferSize];
+    int m_tcpReadSize;
+    TripleBuffer<RadarScan> m_scans;   // Link thread writes, GUI thread reads
+    std::atomic<bool> m_scanNotifyPending;
+
+    // Written on the link thread, read anywhere
+    std::atomic<quint64> m_udpBytesSent;
+    std::atomic<quint64> m_tcpBytesSent;
+    std::atomic<quint64> m_sendErrors;
+    std::atomic<quint64> m_tcpReconnects;
+    std::atomic<quint64> m_queueOverflows;
+    std::atomic<quint64> m_stopCommands;
+    std::atomic<quint64> m_preempted;
+    std::atomic<quint64> m_batches;
+    std::atomic<quint64> m_batchedCommands;
+    std::atomic<quint64> m_tcpQueueDepth;
+    std::atomic<quint64> m_tcpQueueDropped;
+    std::atomic<quint64> m_tcpReplayed;
+    std::atomic<qint64> m_tcpReconnectNs;
+    std::atomic<quint64> m_acks;
+    std::atomic<quint64> m_lost;
+    std::atomic<quint64> m_retransmissions;
+    std::atomic<qint64> m_smoothedRttNs;
+    std::atomic<double> m_lossRate;
+    std::atomic<quint64> m_scansReceived;
+    std::atomic<quint64> m_scansMalformed;
+    LatencyHistogram m_inputToWire;
+
+    static bool isReliable(const ControlCommand &command);
+    static bool isMotion(const ControlCommand &command);
+    void sendEmergencyStop();
+    void send(const ControlCommand &command);
+    static QString stateCommand(const ControlCommand &command);
+    void sendCommand(const QString &command, const ControlCommand &source);
+    // Sends the message last encoded into m_protocol
+    void sendMessage(int size, const ControlCommand &source);
+    void addToBatch(const char *data, int size, bool text, quint32 sequence, const ControlCommand &source);
+    bool sendUdpData(const char *data, qint64 size);
+    void sendTcpData(const char *data, qint64 size);
+    bool tcpWritable() const;
+    void queueTcpCommand(const char *data, int size, ControlProtocol::MessageType type, bool binary, bool motion);
+    void sendTcpQueue();
+    void removeTcpQueued(int index, int count);
+    void clearTcpQueue();
+    void tcpWentDown();
+    void scheduleReconnect();
+    void scheduleRetransmit();
+    void publishLinkQuality();
+    void connectToServer();
+    // Decodes a Scan message and hands it to the GUI thread
+    void receiveScan(const char *data, qint64 size);
+    // A binary message or text line from the TCP stream that may ACK a STOP
+    void receiveTcpAck(const char *data, int size);
+    void stopAcknowledged(qint64 rttNs);
+};
+
+#endif // CONTROLLINK_H
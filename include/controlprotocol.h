@@ -0,0 +1,127 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+
+#include <QtGlobal>
+
+class QString;
+struct RadarScan;
+
+// Fixed-layout binary encoding of controller commands, an alternative to
+// the BUTTON:/TOUCH:/MODE: text commands. Every message is a 20-byte header
+// followed by a type-specific payload, all integers big-endian:
+//
+//   offset  size  field
+//        0     2  magic 0x4B43 ("KC")
+//        2     1  version (1)
+//        3     1  message type
+//        4     4  sequence number, +1 per message
+//        8     8  send time, nanoseconds on the sender's monotonic clock
+//       16     2  payload length
+//       18     2  flags (bit 0: retransmission)
+//
+// Payloads: Button = 1 byte button code, Touch = int32 x + int32 y,
+// Mode = 1 byte (0 manual, 1 auto), State = 1 byte held directions
+// (bit 0 up, 1 down, 2 left, 3 right) + 1 byte flags (bit 0: edge sample) +
+// int16 stick x + int16 stick y (-32767..32767, deadbanded), Stop = no
+// payload. The sequence number lets a receiver
+// detect lost and reordered messages; the timestamps give one-way delay
+// variation.
+//
+// A Batch carries several messages sent together in one datagram or TCP
+// write: uint16 count, then that many complete messages back to back. Its
+// own header has sequence number 0 and is never acknowledged; the server
+// acknowledges the messages inside as if they had arrived one by one.
+//
+// Telemetry flows the other way: the server sends Scan messages over UDP or
+// the TCP connection, whatever format the commands use. Payload: uint16
+// point count, then per point uint16 distance in millimeters and uint16
+// angle in hundredths of a degree (0-18000), at most 360 points so a scan
+// fits one datagram. Scans are not acknowledged.
+//
+// The server acknowledges a message with an Ack header (no payload) that
+// carries the message's sequence number and echoes its send time, so the
+// sender gets the round-trip time from its own clock, retransmissions
+// included.
+//
+// Messages are encoded into a buffer owned by the encoder, so sending one
+// does not allocate. The data stays valid until the next encode call.
+class ControlProtocol
+{
+public:
+    enum Format {
+        Text,   // BUTTON:UP etc., newline terminated over TCP
+        Binary  // The layout above, self-delimiting over TCP
+    };
+
+    enum MessageType : quint8 {
+        ButtonMessage = 1,
+        TouchMessage = 2,
+        ModeMessage = 3,
+        AckMessage = 4,
+        StateMessage = 5,
+        BatchMessage = 6,
+        StopMessage = 7,
+        ScanMessage = 8
+    };
+
+    enum Flag : quint16 {
+        RetransmitFlag = 0x0001
+    };
+
+    enum ButtonCode : quint8 {
+        UnknownButton = 0,
+        ButtonUp = 1,
+        ButtonDown = 2,
+        ButtonLeft = 3,
+        ButtonRight = 4
+    };
+
+    static const quint16 Magic = 0x4B43;
+    static const quint8 Version = 1;
+    static const int HeaderSize = 20;
+    static const int MaxMessageSize = HeaderSize + 8;
+    static const int BatchHeaderSize = HeaderSize + 2;
+
+    // Each returns the size of the encoded message in data()
+    int encodeButton(ButtonCode button);
+    int encodeTouch(qint32 x, qint32 y);
+    int encodeMode(bool autoMode);
+    int encodeState(quint8 directions, qint16 axisX, qint16 axisY, bool edge);
+    int encodeStop();
+
+    const char *data() const { return m_buffer; }
+
+    // Writes a Batch header (BatchHeaderSize bytes) for count messages
+    // taking messagesSize bytes
+    static void writeBatchHeader(char *header, quint16 count, int messagesSize);
+
+    // Sets the send time of an encoded message, e.g. when it was held back
+    // before sending
+    static void stamp(char *message, qint64 sentNs);
+
+    // Refreshes the send time of an encoded message before it is sent again
+    // and marks it as a retransmission
+    static void restamp(char *message);
+
+    // Parses an Ack; false if data isn't one
+    static bool decodeAck(const char *data, qint64 size, quint32 *sequence, qint64 *sentNs);
+    // Size of the message at data once size bytes are enough to tell: 0 if
+    // the header is incomplete, -1 if data doesn't start a valid header
+    static int messageSize(const char *data, qint64 size);
+    // Parses a complete Scan message into scan; false if malformed
+    static bool decodeScan(const char *data, qint64 size, RadarScan *scan);
+    // Sequence number of the last encoded message
+    quint32 sequence() const { return m_sequence; }
+
+    // "UP", "DOWN", "LEFT", "RIGHT" -> code; anything else is UnknownButton
+    static ButtonCode buttonCode(const char *name);
+    static Format formatFromName(const QString &name, bool *ok = nullptr);
+
+private:
+    int finish(MessageType type, int payloadSize);
+
+    char m_buffer[MaxMessageSize] = {};
+    quint32 m_sequence = 0;
+};
+
+#endif // CONTROLPROTOCOL_H
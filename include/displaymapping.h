@@ -0,0 +1,32 @@
+#ifndef DISPLAYMAPPING_H
+#define DISPLAYMAPPING_H
+
+#include <QImage>
+#include <QPointF>
+#include <QRect>
+#include <QSizeF>
+#include "capturesource.h"
+#include "framepool.h"
+
+// How captured frames and robot data land on the screen. Free functions of
+// their inputs only, so the widgets and the capture thread share them with
+// the benchmarks.
+
+// Fused convert/crop/scale/rotate of a captured frame into a pooled RGB32
+// image of displaySize (the source size if empty). The source is cropped to
+// the display aspect ratio, centred, like Qt::KeepAspectRatioByExpanding.
+// Returns a null image if the frame can't be shown or the pool is out of
+// memory.
+QImage frameToQImage(const CaptureFrame &frame, const QSize &displaySize, bool rotate180, FramePool &pool);
+
+// Maps a position to normalized (0..1, clamped) stream coordinates, for a
+// frameSize stream shown letterboxed (Qt::KeepAspectRatio, centred) in
+// videoRect
+QPointF normalizeCoordinates(const QPoint &position, const QRect &videoRect, const QSize &frameSize);
+
+// Converts a radar point (meters; degrees, 0 right to 180 left) to
+// coordinates in a view of viewSize, with the radar at its bottom centre
+// and maxDistance reaching almost to the top
+QPointF radarToWidget(float distance, float angle, const QSizeF &viewSize, float maxDistance);
+
+#endif // DISPLAYMAPPING_H
@@ -7,6 +7,7 @@
 #include <QColor>
 #include <QVector>
 #include <QPointF>
+#include "radarscan.h"
 
 // Structure to represent a point in the radar display
 struct RadarPoint {
@@ -32,10 +33,17 @@ public:
     
     // Clear all points
     void clearPoints();
+
+    // Replaces all points with a received scan and repaints once. The first
+    // scan ends the simulation.
+    void setScan(const RadarScan &scan);
     
     // Simulates radar data for testing
     void generateSimulatedData();
 
+    // Display orientation: draw rotated by 180 degrees and/or scaled up
+    void setDisplayTransform(bool rotate180, qreal scale);
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void timerEvent(QTimerEvent *event) override;
@@ -46,7 +54,14 @@ private:
     int m_mapWidth = 100;
     int m_mapHeight = 100;
     float m_maxDistance = 10.0f;  // Maximum distance in meters
-    int m_animationTimerId;
+    int m_animationTimerId;       // 0 once live scans arrive
+    bool m_live = false;
+    bool m_rotated180 = false;
+    qreal m_scale = 1.0;
+
+    // Size of the drawing area before scaling
+    float viewWidth() const { return width() / m_scale; }
+    float viewHeight() const { return height() / m_scale; }
     
     // Converts radar coordinates to widget coordinates
     QPointF radarToWidget(float distance, float angle);
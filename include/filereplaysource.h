@@ -0,0 +1,74 @@
+#ifndef FILEREPLAYSOURCE_H
+#define FILEREPLAYSOURCE_H
+
+#include "capturesource.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <vector>
+
+#ifdef OPENCV_ENABLED
+#include <opencv2/opencv.hpp>
+#endif
+
+// Plays a local recording at its recorded timing, looping at the end.
+//
+// URL format: file:///path/to/recording
+//   *.kraw   raw frame dump (see below), always available
+//   other    any video file cv::VideoCapture can decode (OpenCV builds only)
+//
+// .kraw layout, little-endian:
+//   header  "KRIARAW1", uint32 width, uint32 height, uint32 channels (1 or 3),
+//           uint32 reserved
+//   frames  int64 capture timestamp in microseconds, then height * width *
+//           channels bytes of tightly packed BGR24 or Gray8 pixels
+class FileReplaySource : public CaptureSource
+{
+public:
+    explicit FileReplaySource(const QString &path);
+    ~FileReplaySource() override;
+
+    bool open() override;
+    void close() override;
+    bool grab() override;
+    bool retrieve(CaptureFrame &frame) override;
+    QSize frameSize() const override;
+
+    static std::unique_ptr<CaptureSource> create(const QString &url);
+    static bool supportsUrl(const QString &url);
+
+private:
+    QString m_path;
+    bool m_rawDump;
+    QSize m_frameSize;
+    int m_channels = 3;
+
+    // Replay timing: stream time of the first frame of the current loop is
+    // pinned to the wall clock, later frames are held back until they are due
+    QElapsedTimer m_clock;
+    qint64 m_loopStartUs = -1;   // Stream timestamp of the first frame
+    qint64 m_wallOffsetUs = 0;   // Wall clock time at which it was shown
+    qint64 m_lastTimestampUs = 0;
+    void waitForTimestamp(qint64 timestampUs);
+    void restartLoop();
+
+    // .kraw dumps
+    QFile m_file;
+    qint64 m_frameBytes = 0;
+    qint64 m_pendingFrameOffset = -1; // Pixels of the grabbed frame
+    std::vector<uchar> m_pixels;
+    bool grabRaw();
+    bool retrieveRaw(CaptureFrame &frame);
+
+#ifdef OPENCV_ENABLED
+    // Video files
+    cv::VideoCapture m_capture;
+    cv::Mat m_frame;
+    cv::Mat m_converted;
+    bool grabVideo();
+    bool retrieveVideo(CaptureFrame &frame);
+#endif
+
+    static QString pathFromUrl(const QString &url);
+};
+
+#endif // FILEREPLAYSOURCE_H
@@ -0,0 +1,46 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+// Recycles full-size image buffers between the capture thread and the
+// display path. Images handed out by acquire() wrap pooled memory and give
+// it back automatically when the last QImage copy referencing it goes away,
+// so after warm-up no per-frame heap allocation takes place.
+class FramePool
+{
+public:
+    explicit FramePool(int maxIdleBuffers = 6);
+    ~FramePool();
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // Returns an unshared image of the given size and format. The contents
+    // are undefined; callers are expected to overwrite every pixel.
+    QImage acquire(const QSize &size, QImage::Format format);
+
+    // Drop all idle buffers (e.g. after the stream resolution changed)
+    void trim();
+
+    // Pool statistics
+    quint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    quint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Shared;
+    struct Buffer;
+
+    static void releaseBuffer(void *info);
+
+    std::shared_ptr<Shared> m_shared;
+    std::atomic<quint64> m_hits;
+    std::atomic<quint64> m_misses;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,101 @@
+#ifndef GUIWATCHDOG_H
+#define GUIWATCHDOG_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include "latencyhistogram.h"
+
+// Watches the GUI thread, which frames, input handlers, shortcuts and the
+// radar animation all share.
+//
+// - Event-loop lag: a precise heartbeat timer measures how late it fires.
+// - Handler durations: handlers opened with GUI_WATCHDOG_SCOPE() get a
+//   histogram each, and any run longer than the stall threshold is logged
+//   with the handler's name.
+// - Stalls in progress: a monitor thread notices when the heartbeat stops
+//   and logs which handler the GUI thread is stuck in.
+class GuiWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Statistics of one instrumented handler. Instances are static, created
+    // by GUI_WATCHDOG_SCOPE() and linked into a list that is never freed.
+    class Handler
+    {
+    public:
+        explicit Handler(const char *name);
+
+        const char *name() const { return m_name; }
+        const LatencyHistogram &histogram() const { return m_histogram; }
+        const Handler *next() const { return m_next; }
+
+    private:
+        friend class GuiWatchdog;
+        const char *m_name;
+        LatencyHistogram m_histogram;
+        Handler *m_next = nullptr;
+    };
+
+    // Times one run of a handler (GUI thread only)
+    class Scope
+    {
+    public:
+        explicit Scope(Handler &handler);
+        ~Scope();
+
+    private:
+        Handler &m_handler;
+        const char *m_outer;
+        qint64 m_startNs;
+    };
+
+    explicit GuiWatchdog(QObject *parent = nullptr);
+    ~GuiWatchdog();
+
+    void start();
+    void stop();
+
+    // Handler runs and heartbeat gaps longer than this are logged
+    static void setStallThreshold(int milliseconds);
+    static int stallThreshold();
+
+    const LatencyHistogram &eventLoopLag() const { return m_lag; }
+    quint64 stallCount() const { return s_stalls.load(std::memory_order_relaxed); }
+
+    // All handlers that have run at least once
+    static const Handler *handlers();
+
+    // Event loop lag and per-handler duration percentiles, one line each
+    QString report() const;
+
+private slots:
+    void heartbeat();
+
+private:
+    static const int HeartbeatMs = 10;
+
+    QTimer m_heartbeat;
+    LatencyHistogram m_lag;
+    qint64 m_expectedBeatNs = 0;
+    std::atomic<qint64> m_lastBeatNs;
+    std::atomic<bool> m_running;
+    QThread *m_monitor = nullptr;
+
+    void monitor();
+
+    static std::atomic<qint64> s_stallThresholdNs;
+    static std::atomic<const char*> s_currentHandler;
+    static std::atomic<Handler*> s_handlers;
+    static std::atomic<quint64> s_stalls;
+};
+
+// Declares a statically allocated handler and times the rest of the
+// enclosing block against it
+#define GUI_WATCHDOG_SCOPE(name) \
+    static GuiWatchdog::Handler guiWatchdogHandler(name); \
+    GuiWatchdog::Scope guiWatchdogScope(guiWatchdogHandler)
+
+#endif // GUIWATCHDOG_H
@@ -0,0 +1,96 @@
+#ifndef INPUTSAMPLER_H
+#define INPUTSAMPLER_H
+
+#include <QObject>
+#include <QTimer>
+
+// Held directions and stick position at one instant
+struct InputState {
+    quint8 directions = 0;  // InputSampler::Direction bits
+    qint16 axisX = 0;       // Deadbanded stick position, -32767..32767
+    qint16 axisY = 0;
+
+    bool isIdle() const { return directions == 0 && axisX == 0 && axisY == 0; }
+    bool operator==(const InputState &other) const
+    {
+        return directions == other.directions && axisX == other.axisX && axisY == other.axisY;
+    }
+    bool operator!=(const InputState &other) const { return !(*this == other); }
+};
+
+// Turns key, gamepad button and stick events into a sampled input state.
+// Press/release is tracked per source, so holding a direction on one source
+// survives releasing it on another and key auto-repeat changes nothing.
+//
+// Every change of the held directions, and a stick entering or leaving its
+// deadband, is emitted right away as an edge sample. While anything is held
+// the state is also emitted once per tick, so the receiver can treat missing
+// ticks as "released" (hold-to-move). Stick movement within the active range
+// is coalesced into the ticks. Nothing is emitted while idle.
+class InputSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Direction : quint8 {
+        Up = 0x01,
+        Down = 0x02,
+        Left = 0x04,
+        Right = 0x08
+    };
+
+    enum Source {
+        ArrowKeys,
+        WasdKeys,
+        GamepadButtons,
+        OnScreenButtons,
+        SourceCount
+    };
+
+    enum Axis {
+        AxisX,
+        AxisY
+    };
+
+    explicit InputSampler(QObject *parent = nullptr);
+
+    // Samples per second while input is held (default 50)
+    void setTickRate(int hz);
+    int tickRate() const;
+
+    // Stick values below this magnitude (0..1) read as zero; the rest of the
+    // range is rescaled so the output still starts at zero (default 0.15)
+    void setDeadband(double deadband);
+
+    void setDirection(Source source, Direction direction, bool held);
+    // value is the raw stick position, -1..1
+    void setAxis(Axis axis, double value);
+    // Releases everything, e.g. when the window loses focus
+    void releaseAll();
+
+    InputState state() const { return m_state; }
+
+    // "UP", "DOWN", "LEFT", "RIGHT" <-> Direction; 0 if unknown
+    static Direction directionFromName(const QString &name);
+    static const char *directionName(Direction direction);
+
+signals:
+    // edge is true for samples caused by a press, release or a stick
+    // becoming (in)active, false for periodic ticks
+    void sampled(const InputState &state, bool edge);
+
+private slots:
+    void onTick();
+
+private:
+    QTimer m_tickTimer;
+    quint8 m_held[SourceCount];
+    double m_rawAxis[2];
+    double m_deadband;
+    InputState m_state;
+
+    void update();
+    qint16 applyDeadband(double value) const;
+};
+
+#endif // INPUTSAMPLER_H
@@ -0,0 +1,50 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Fixed-size log-linear histogram of durations in nanoseconds. Every power
+// of two is split into 16 buckets, so any value is reported within ~6% of
+// what was recorded, from 1 ns up to ~78 hours (larger values are clamped).
+//
+// record() is wait-free and may be called from any number of threads; it
+// never locks or allocates, so histograms can stay enabled in production.
+// Reads are not atomic as a whole: a snapshot taken while other threads
+// record can be off by the few samples in flight.
+class LatencyHistogram
+{
+public:
+    struct Summary {
+        quint64 count = 0;
+        qint64 sum = 0;
+        qint64 mean = 0;
+        qint64 p50 = 0;
+        qint64 p90 = 0;
+        qint64 p99 = 0;
+        qint64 p999 = 0;
+        qint64 max = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(qint64 nanoseconds);
+    Summary summary() const;
+    void reset();
+
+private:
+    static const int SubBucketBits = 4;
+    static const int SubBuckets = 1 << SubBucketBits;
+    static const int MaxExponent = 47;
+    static const int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    std::atomic<quint64> m_buckets[BucketCount];
+    std::atomic<quint64> m_count;
+    std::atomic<quint64> m_sum;
+    std::atomic<qint64> m_max;
+
+    static int bucketIndex(quint64 value);
+    static qint64 bucketUpperBound(int index);
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,44 @@
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include "latencyhistogram.h"
+#include <QImage>
+#include <QSize>
+
+// Glass-to-glass latency probe. Decodes the block-coded wall-clock stamp
+// that tests/latency_source.py draws into every frame from the image that
+// was actually painted, and records how old it was. Unlike the in-process
+// stage timers this covers encoding, the network, decoder buffering, the
+// signal queue and the paint.
+class LatencyProbe
+{
+public:
+    struct Stamp {
+        qint64 timestampMs = 0;  // Wall clock modulo 2^40
+        quint16 counter = 0;
+    };
+
+    // Called with each painted frame (display-sized, possibly rotated) and
+    // the size of the stream it was scaled from
+    void framePainted(const QImage &frame, const QSize &streamSize);
+
+    const LatencyHistogram &histogram() const { return m_histogram; }
+    quint64 decodedFrames() const { return m_decoded; }
+    quint64 undecodedFrames() const { return m_undecoded; }
+    quint64 missedFrames() const { return m_missed; }   // Counter gaps: never painted
+
+    // Latency percentiles and frame counts
+    QString report() const;
+
+    static bool decode(const QImage &frame, const QSize &streamSize, Stamp *stamp);
+
+private:
+    LatencyHistogram m_histogram;
+    quint64 m_decoded = 0;
+    quint64 m_undecoded = 0;
+    quint64 m_missed = 0;
+    bool m_haveCounter = false;
+    quint16 m_lastCounter = 0;
+};
+
+#endif // LATENCYPROBE_H
@@ -3,13 +3,19 @@
 
 #include <QMainWindow>
 #include <QTimer>
-#include <QLabel>
 #include <QPainter>
 #include <QPushButton>
 #include <QVector>
+#include <memory>
 #include "rtspstreamer.h"
 #include "distancemap.h"
 #include "nativecontroller.h"
+#include "overlaybutton.h"
+#include "videowidget.h"
+#include "latencyprobe.h"
+#include "guiwatchdog.h"
+#include "metricsserver.h"
+#include "performancehud.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -25,6 +31,49 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Display orientation: rotation (0 or 180 degrees) applied to the video and
+    // the overlay, and a scale factor for the overlay controls
+    void setDisplayOrientation(int rotation, qreal overlayScale);
+
+    // Overrides the RTSP URL derived from the network configuration, e.g.
+    // with a synthetic:// or file:// source (see CaptureSource)
+    void setStreamUrl(const QString &url);
+
+    // Decode the timestamp stamped in by tests/latency_source.py from every
+    // painted frame and record the glass-to-glass latency
+    void setLatencyProbeEnabled(bool enabled);
+
+    // Serve Prometheus metrics on 127.0.0.1:port (0 disables)
+    void setMetricsPort(quint16 port);
+
+    // Wire format of the controller commands (text by default)
+    void setControlProtocol(ControlProtocol::Format format);
+    // Real-time scheduling for the controller's network thread
+    void setControlRealtimePriority(bool enabled);
+    // Hold-to-move sample rate of directional input, 0 for one command per
+    // key press (see NativeController::setInputTickRate)
+    void setInputTickRate(int hz);
+    // Longest a command waits to share a datagram with others, negative to
+    // send each on its own (see NativeController::setBatchLatency)
+    void setControlBatchLatency(int ms);
+    // Local UDP port for the robot's telemetry scans, 0 for none besides
+    // the command socket and TCP (see NativeController::setTelemetryPort)
+    void setTelemetryPort(quint16 port);
+
+    // Capture/display counters of the running stream
+    StreamStats streamStats() const;
+
+    // Per-stage capture → paint latency histograms
+    PipelineLatency &pipelineLatency();
+
+    // Event loop lag and GUI handler durations
+    GuiWatchdog *watchdog() const;
+
+signals:
+    // A frame reached the screen: its grab sequence number and when it
+    // passed each pipeline stage
+    void framePainted(quint64 sequence, const FrameTimestamps &timestamps);
+
 protected:
     // Handle key press events (Esc to exit fullscreen)
     void keyPressEvent(QKeyEvent *event) override;
@@ -36,44 +85,65 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
 
 private slots:
-    void updateFrame(const QImage &frame);
+    void updateFrame();
+    void handleFramePresented(bool painted);
     void handleConnectionError();
     void connectToStream();
     void disconnectFromStream();
     void toggleAutoManual();
     void updateButtonsPosition();
-    void arrowButtonClicked();
+    void arrowButtonPressed();
+    void arrowButtonReleased();
 
 private:
     Ui::MainWindow *ui;
     RTSPStreamer *m_rtspStreamer;
-    QLabel *m_videoLabel;
-    QPushButton *m_toggleButton;
-    QVector<QPushButton*> m_arrowButtons;
+    VideoWidget *m_videoWidget;
+    OverlayButton *m_toggleButton;
+    QVector<OverlayButton*> m_arrowButtons;
     DistanceMap *m_distanceMap;
+    PerformanceHud *m_hud;
     NativeController *m_nativeController;
+    GuiWatchdog *m_watchdog;
+    MetricsServer *m_metricsServer = nullptr;
     QString m_tcpAddress = "192.168.10.102";  // Use localhost for testing
     quint16 m_rtspPort = 554;
     quint16 m_tcpPort = 8080;
     quint16 m_udpPort = 8081;
     QString m_rtspUrl="rtsp://192.168.10.102:554/test";
     bool m_isAutoMode = true; // Start in AUTO mode
+    int m_displayRotation = 180; // Screen is mounted upside down
+    qreal m_overlayScale = 1.6;
+    quint64 m_shownSequence = 0;     // Frame last handed to the video widget
+    FrameTimestamps m_shownTimestamps;
+    std::unique_ptr<LatencyProbe> m_latencyProbe;
     
     void setupUI();
     void setupNativeController();
     void updateButtonStyle();
     void updateArrowButtonsVisibility();
-    QPushButton* createArrowButton(const QString& direction);
+    OverlayButton* createArrowButton(const QString& direction);
+    void setArrowButtonHeld(QPushButton *button, bool held);
+    QPushButton *arrowButton(const QString &directionName) const;
+    static QString arrowDirectionName(const QString &arrowSymbol);
+
+    // Display orientation helpers
+    void applyDisplayOrientation();
+    int scaledSize(int value) const;
+    QPoint overlayPosition(const QPoint &logicalPos, const QSize &size) const;
+    QPoint displayToLogical(const QPoint &pos) const;
     
     // Network configuration
     void setNetworkConfiguration(const QString &address, quint16 rtspPort, quint16 tcpPort, quint16 udpPort);
     
     // Native controller message handlers
     void handleDirectionPress(const QString &direction);
+    void handleDirectionRelease(const QString &direction);
     void handleModeToggle();
     void handleTouchCoordinate(int x, int y);
-    
-    // Coordinate normalization
+    void handleScanReady();
+
+    // Maps a window position to normalized (0..1) stream coordinates
     QPointF normalizeCoordinates(const QPoint &screenCoord) const;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,62 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QByteArray>
+#include <QHash>
+
+class RTSPStreamer;
+class NativeController;
+class GuiWatchdog;
+class LatencyProbe;
+class LatencyHistogram;
+class QTcpSocket;
+
+// Minimal HTTP endpoint serving GET /metrics in the Prometheus text format,
+// bound to localhost only, for a local agent to scrape. Runs on the GUI
+// thread; building a response only reads counters and histograms.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    bool listen(quint16 port);
+    quint16 port() const;
+
+    // Sources of the metrics; any of them may be left unset
+    void setStreamer(RTSPStreamer *streamer);
+    void setController(NativeController *controller);
+    void setWatchdog(GuiWatchdog *watchdog);
+    void setLatencyProbe(LatencyProbe *probe);
+
+    // The full exposition text
+    QByteArray metrics() const;
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+
+private:
+    // Largest request header accepted before the connection is dropped
+    static const int MaxRequestBytes = 8192;
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_requests;
+    RTSPStreamer *m_streamer = nullptr;
+    NativeController *m_controller = nullptr;
+    GuiWatchdog *m_watchdog = nullptr;
+    LatencyProbe *m_latencyProbe = nullptr;
+
+    void respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType,
+                 const QByteArray &body);
+
+    static void writeHeader(QByteArray &out, const char *name, const char *type, const char *help);
+    static void writeValue(QByteArray &out, const char *name, const QByteArray &labels, double value);
+    static void writeSummary(QByteArray &out, const char *name, const QByteArray &labels,
+                             const LatencyHistogram &histogram);
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,21 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// The clock behind every timestamp Kria compares: pipeline and display
+// stages, control-link send and ACK times, the watchdog and the HUD.
+// Nanoseconds since an unspecified point, so only differences between two
+// readings in the same process mean anything.
+class MonotonicClock
+{
+public:
+    static qint64 timestampNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // MONOTONICCLOCK_H
@@ -2,11 +2,11 @@
 #define NATIVECONTROLLER_H
 
 #include <QObject>
-#include <QUdpSocket>
-#include <QTcpSocket>
-#include <QTimer>
+#include <QThread>
 #include <QKeyEvent>
 #include <QShortcut>
+#include "controllink.h"
+#include "inputsampler.h"
 
 #ifdef QT_GAMEPAD_ENABLED
 #include <QGamepad>
@@ -34,19 +34,81 @@ public:
     void setServerAddress(const QString &address);
     void setUdpPort(quint16 port);
     void setTcpPort(quint16 port);
+    // Also receive telemetry on this local UDP port (0: only on the command
+    // socket and the TCP connection)
+    void setTelemetryPort(quint16 port);
+
+    // Wire format of the commands; text by default. The server has to
+    // expect the same format.
+    void setProtocolFormat(ControlProtocol::Format format);
+    ControlProtocol::Format protocolFormat() const;
     
     // Send commands to server
     void sendButtonPress(const QString &button);
     void sendTouchCoordinate(int x, int y);
     void sendModeChange(bool autoMode);
+
+    // STOP ahead of all other commands, over each enabled transport, until
+    // acknowledged. Also releases all held directions. Bound to X and the
+    // gamepad's Start.
+    void sendEmergencyStop();
+
+    // Commands sent while a Batch exists reach the network thread together
+    // when the outermost Batch ends, so they go out in one datagram. For
+    // handlers that send several commands for one event.
+    class Batch
+    {
+    public:
+        explicit Batch(NativeController *controller);
+        ~Batch();
+
+    private:
+        Q_DISABLE_COPY(Batch)
+        NativeController *m_controller;
+    };
+
+    // Longest a command may wait for others to share its datagram; 0
+    // (default) only batches commands that are pending at the same time,
+    // negative sends every command on its own
+    void setBatchLatency(int ms);
+
+    // Held state of a direction from the on-screen buttons ("UP", ...)
+    void setDirectionHeld(const QString &direction, bool held);
+
+    // Directional input is sampled and sent as STATE messages this many
+    // times per second while held, plus immediately on press and release
+    // (default 50). 0 sends one BUTTON command per key/gamepad event instead.
+    void setInputTickRate(int hz);
+    InputSampler *inputSampler() const;
     
+    ControllerStats stats() const;
+
+    // Returns once the network thread has handled everything sent before,
+    // for benchmarks and tests; never call it from that thread
+    void waitForLink();
+
+    // Round-trip times of acknowledged UDP commands
+    const LatencyHistogram &roundTripTime() const;
+    // Time from an input handler queuing a command to it reaching the socket
+    const LatencyHistogram &inputToWire() const;
+
+    // Newest telemetry scan since the last call, or nullptr; valid until
+    // the next call. Call after scanReady().
+    const RadarScan *takeScan();
+
+    // Run the network thread with real-time scheduling, so commands go out
+    // promptly even when video decoding saturates the CPU
+    void setRealtimePriority(bool enabled);
+
     // Install event filter for global key events
     void installGlobalKeyFilter(QWidget *widget);
 
 signals:
     // Local control signals (for UI)
     void directionPressed(const QString &direction);
+    void directionReleased(const QString &direction);
     void modeTogglePressed();
+    void emergencyStopPressed();
     void touchCoordinateReceived(int x, int y);
     
     // Status signals
@@ -54,30 +116,46 @@ signals:
     void controllerStopped();
     void serverConnected();
     void serverDisconnected();
+    // The text command, or "#<sequence>" for a binary message
     void commandSent(const QString &command);
     void errorOccurred(const QString &error);
 
+    // UDP link quality, updated as ACKs arrive and commands time out.
+    // lossRate is a moving average of unacknowledged datagrams (0..1).
+    void roundTripTimeMeasured(double rttMs);
+    void linkQualityChanged(double smoothedRttMs, double lossRate);
+    // The server acknowledged a STOP; rttMs is -1 if unknown
+    void emergencyStopAcknowledged(double rttMs);
+    // The server sent a scan; fetch it with takeScan()
+    void scanReady();
+
+protected:
+    // Direction key press/release, installed application-wide
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
 private slots:
-    // TCP client control
-    void onTcpConnected();
-    void onTcpDisconnected();
-    void onTcpError(QAbstractSocket::SocketError error);
-    void reconnectToServer();
-    
     // Gamepad control
     void onGamepadConnected(int deviceId);
     void onGamepadDisconnected(int deviceId);
-    void onGamepadButtonPressed(int button);
+    void onGamepadButtonChanged(int button, bool pressed);
     void onGamepadAxisChanged(int axis, double value);
+
+    // Input state samples (edges and ticks)
+    void onInputSampled(const InputState &state, bool edge);
     
     // Keyboard shortcuts
     void onKeyboardShortcut();
 
 private:
-    // Network components
-    QUdpSocket *m_udpSocket;
-    QTcpSocket *m_tcpClient;
-    QTimer *m_reconnectTimer;
+    // Sockets and encoding run on their own thread, away from the paints
+    QThread *m_linkThread;
+    ControlLink *m_link;
+
+    InputSampler *m_sampler;
+    bool m_sampling;             // Tick rate > 0
+    quint8 m_shownDirections;    // Reported through directionPressed/Released
     
     // Gamepad
 #ifdef QT_GAMEPAD_ENABLED
@@ -95,14 +173,18 @@ private:
     bool m_gamepadEnabled;
     bool m_udpEnabled;
     bool m_tcpEnabled;
-    bool m_autoReconnect;
+    ControllerStats m_stats;     // Command counts; the link adds the traffic
+    ControlProtocol::Format m_protocolFormat = ControlProtocol::Text;
+    int m_batchDepth = 0;        // Nested Batch scopes alive
+    quint32 m_batchGroup = 0;    // Id of the outermost Batch, see ControlCommand::group
     
     // Helper methods
     void setupKeyboardShortcuts(QWidget *parent);
     void setupGamepad();
-    void sendUdpCommand(const QString &command);
-    void sendTcpCommand(const QString &command);
-    void connectToServer();
+    void post(ControlCommand &command);
+    // Runs f on the link thread
+    template <typename Function>
+    void invokeOnLink(Function f);
 };
 
 #endif // NATIVECONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef OPENCVCAPTURESOURCE_H
+#define OPENCVCAPTURESOURCE_H
+
+#ifdef OPENCV_ENABLED
+#include "capturesource.h"
+#include <opencv2/opencv.hpp>
+
+// Network stream (RTSP and anything else cv::VideoCapture can open)
+class OpenCvCaptureSource : public CaptureSource
+{
+public:
+    explicit OpenCvCaptureSource(const QString &url);
+    ~OpenCvCaptureSource() override;
+
+    bool open() override;
+    void close() override;
+    bool grab() override;
+    bool retrieve(CaptureFrame &frame) override;
+    QSize frameSize() const override;
+
+    // Retrieves the grabbed frame of capture into frame (reused buffer) and
+    // describes it in out, BGRA converted to BGR into converted. Shared by
+    // every cv::VideoCapture based source.
+    static bool retrieveFrom(cv::VideoCapture &capture, cv::Mat &frame, cv::Mat &converted, CaptureFrame &out);
+
+private:
+    QString m_url;
+    cv::VideoCapture m_capture;
+    cv::Mat m_frame;      // Reused by the decoder frame after frame
+    cv::Mat m_converted;  // For decoders that output BGRA
+    QSize m_frameSize;
+};
+#endif // OPENCV_ENABLED
+
+#endif // OPENCVCAPTURESOURCE_H
@@ -0,0 +1,26 @@
+#ifndef OVERLAYBUTTON_H
+#define OVERLAYBUTTON_H
+
+#include <QPushButton>
+
+// Push button for the video overlay that can draw itself rotated by 180
+// degrees, so the overlay follows the display orientation without routing
+// the whole window through a QGraphicsView.
+class OverlayButton : public QPushButton
+{
+    Q_OBJECT
+
+public:
+    explicit OverlayButton(const QString &text, QWidget *parent = nullptr);
+
+    void setRotated180(bool rotated);
+    bool isRotated180() const { return m_rotated180; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    bool m_rotated180 = false;
+};
+
+#endif // OVERLAYBUTTON_H
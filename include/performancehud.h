@@ -0,0 +1,83 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QStaticText>
+#include <QFont>
+#include <QVector>
+#include "rtspstreamer.h"
+#include "nativecontroller.h"
+#include "processusage.h"
+
+// Heads-up display of live pipeline and control statistics, layered over
+// the video like DistanceMap. Values are sampled twice a second; each line
+// is a QStaticText whose glyph layout is cached and only redone when its
+// text changes, and the widget is only repainted when a line changed. It
+// paints an opaque background, so video frames never force it to repaint.
+class PerformanceHud : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PerformanceHud(QWidget *parent = nullptr);
+
+    void setStreamer(RTSPStreamer *streamer);
+    void setController(NativeController *controller);
+
+    // Display orientation: draw rotated by 180 degrees and/or scaled up
+    void setDisplayTransform(bool rotate180, qreal scale);
+
+public slots:
+    // Connected to MainWindow::framePainted
+    void framePainted(quint64 sequence, const FrameTimestamps &timestamps);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    enum Line {
+        FpsLine,
+        FrameAgeLine,
+        DecodeLine,
+        ConvertLine,
+        DeliverLine,
+        PaintLine,
+        DroppedLine,
+        CommandsLine,
+        CpuLine,
+        LineCount
+    };
+
+    static const int RefreshMs = 500;
+    static const int LineChars = 34; // Widest line the layout is sized for
+
+    RTSPStreamer *m_streamer = nullptr;
+    NativeController *m_controller = nullptr;
+    QTimer m_refreshTimer;
+    QFont m_font;
+    QVector<QStaticText> m_lines;
+    bool m_rotated180 = false;
+    qreal m_scale = 1.0;
+    int m_lineHeight = 0;
+
+    // Previous sample, for rates
+    qint64 m_sampleNs = 0;
+    StreamStats m_stats;
+    ControllerStats m_controllerStats;
+    ProcessUsage m_usage;
+    qint64 m_lastPaintedNs = 0;
+
+    void setLine(Line line, const QString &text);
+    static QString rateText(double value, bool valid, int width, int precision);
+    QString stageText(const char *label, PipelineLatency::Stage stage) const;
+    void updateGeometryForFont();
+    QTransform textTransform() const;
+};
+
+#endif // PERFORMANCEHUD_H
@@ -0,0 +1,53 @@
+#ifndef PIPELINELATENCY_H
+#define PIPELINELATENCY_H
+
+#include "latencyhistogram.h"
+#include <QString>
+
+// When a frame passed each point of the capture → display pipeline, on the
+// MonotonicClock::timestampNs() clock. Zero means the point wasn't reached.
+struct FrameTimestamps {
+    qint64 grabbed = 0;    // grab() returned
+    qint64 decoded = 0;    // retrieve() returned the pixels
+    qint64 converted = 0;  // Display-sized image ready (scaled, rotated)
+    qint64 published = 0;  // Handed to the GUI, frameReady() emitted
+    qint64 received = 0;   // Picked up by MainWindow::updateFrame()
+    qint64 presented = 0;  // Accepted by the video widget
+    qint64 painted = 0;    // paintEvent() finished drawing it
+};
+
+// Latency histogram per pipeline stage. The capture thread records its
+// stages when a frame is published, the GUI thread the rest once the frame
+// has been painted.
+class PipelineLatency
+{
+public:
+    enum Stage {
+        Decode,    // grabbed   -> decoded
+        Convert,   // decoded   -> converted
+        Publish,   // converted -> published
+        Deliver,   // published -> received (event queue)
+        Present,   // received  -> presented
+        Paint,     // presented -> painted
+        Total,     // grabbed   -> painted
+        StageCount
+    };
+
+    void recordCaptured(const FrameTimestamps &timestamps);
+    void recordPainted(const FrameTimestamps &timestamps);
+
+    const LatencyHistogram &histogram(Stage stage) const { return m_histograms[stage]; }
+    void reset();
+
+    static const char *stageName(Stage stage);
+
+    // One line per stage with count, mean, p50/p99/p99.9 and max in ms
+    QString report() const;
+
+private:
+    LatencyHistogram m_histograms[StageCount];
+
+    void record(Stage stage, qint64 from, qint64 to);
+};
+
+#endif // PIPELINELATENCY_H
@@ -0,0 +1,15 @@
+#ifndef PROCESSUSAGE_H
+#define PROCESSUSAGE_H
+
+#include <QtGlobal>
+
+// CPU time and memory of this process, 0 where the platform can't tell
+struct ProcessUsage {
+    double cpuSeconds = 0;      // User + system time of all threads
+    qint64 residentBytes = 0;   // Current resident set size
+    qint64 peakResidentBytes = 0;
+
+    static ProcessUsage current();
+};
+
+#endif // PROCESSUSAGE_H
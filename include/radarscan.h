@@ -0,0 +1,23 @@
+#ifndef RADARSCAN_H
+#define RADARSCAN_H
+
+#include <QtGlobal>
+
+// One complete distance scan from the robot (radar/LiDAR), as received in a
+// telemetry Scan message. Fixed size, so scans can be decoded into
+// preallocated slots and handed between threads without allocating.
+struct RadarScan {
+    static const int MaxPoints = 360;
+
+    struct Point {
+        float distance;  // Meters
+        float angle;     // Degrees, 0 (right) to 180 (left)
+    };
+
+    quint32 sequence = 0;    // Message sequence number from the sender
+    qint64 receivedNs = 0;   // MonotonicClock::timestampNs() on arrival
+    int count = 0;
+    Point points[MaxPoints];
+};
+
+#endif // RADARSCAN_H
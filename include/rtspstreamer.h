@@ -6,11 +6,30 @@
 #include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QElapsedTimer>
+#include <atomic>
+#include "triplebuffer.h"
+#include "framepool.h"
+#include "capturesource.h"
+#include "pipelinelatency.h"
 
-// Check if OpenCV is enabled at compile time
-#ifdef OPENCV_ENABLED
-#include <opencv2/opencv.hpp>
-#endif
+// Frame counters for the capture/display pipeline
+struct StreamStats {
+    quint64 framesGrabbed = 0;    // Pulled from the network/decoder
+    quint64 framesRetrieved = 0;  // Decoded into pixels
+    quint64 framesConverted = 0;  // Converted for display and published
+    quint64 framesDisplayed = 0;  // Actually painted by the GUI
+    quint64 framesDropped = 0;    // Skipped, failed or replaced before painting
+    quint64 reconnects = 0;       // Source reopened after a failure
+    qint64 timeToFirstFrameNs = 0; // Connect to first published frame, last connection
+};
+
+// A published frame and where it came from
+struct VideoFrame {
+    QImage image;
+    quint64 sequence = 0;        // Number of the grab that produced it
+    FrameTimestamps timestamps;  // Capture side filled in; the GUI adds the rest
+};
 
 class RTSPStreamer : public QThread
 {
@@ -20,10 +39,17 @@ public:
     explicit RTSPStreamer(QObject *parent = nullptr);
     ~RTSPStreamer();
 
+    // Stream to capture from; the URL scheme selects the capture backend
+    // (see CaptureSource::create)
     void setUrl(const QString &url);
     void stopStreaming();
     bool isStreaming() const;
+
+    // Returns the newest decoded frame without blocking the capture thread.
+    // Must only be called from the GUI thread (single consumer).
     QImage getCurrentFrame() const;
+    // Same, with the frame's sequence number and capture time
+    VideoFrame currentFrame() const;
     void setLowLatencyMode(bool enabled);
     
     // Get stream dimensions
@@ -31,27 +57,64 @@ public:
     int getStreamWidth() const;
     int getStreamHeight() const;
 
+    // Size and orientation the video is displayed at. When set, frames are
+    // cropped, scaled (area-averaged when shrinking), rotated and converted on
+    // the capture thread so the GUI only has to blit them. Safe to call from
+    // any thread, e.g. on every resize.
+    void setDisplayTransform(const QSize &size, bool rotate180);
+
+    // Buffer pool shared by the capture thread and the display path
+    FramePool &framePool();
+
+    // Called by the consumer once the last frame handed to it was painted
+    // or replaced by a newer one. Until then, or ConsumerTimeoutMs (e.g.
+    // while the display is hidden), new frames are only grabbed so the
+    // decoder stays drained, but not retrieved and converted.
+    void acknowledgeFrame(bool displayed);
+
+    StreamStats stats() const;
+
+    // Per-stage latency histograms, shared with the GUI which records the
+    // display stages. Lock-free; safe to query from any thread.
+    PipelineLatency &latency();
+
 protected:
     void run() override;
 
 signals:
-    void newFrameAvailable(const QImage &frame);
+    // Emitted when a new frame is published. Notifications are coalesced:
+    // at most one is pending until the consumer calls getCurrentFrame().
+    void frameReady();
     void connectionFailed();
 
 private:
+    // Convert anyway if the consumer hasn't acknowledged a frame for this long
+    static const int ConsumerTimeoutMs = 500;
+
     QString m_rtspUrl;
-    QImage m_currentFrame;
+    FramePool m_framePool;
+    PipelineLatency m_latency;
+    mutable TripleBuffer<VideoFrame> m_frames;
+    std::atomic<bool> m_frameNotifyPending;
     mutable QMutex m_mutex; // Made mutable to allow modification in const methods
     bool m_stopped;
-    bool m_opencvEnabled;
     bool m_lowLatencyMode;
     QSize m_streamSize;
+    std::atomic<quint64> m_displayTransform; // Packed display size and rotation
+    std::atomic<bool> m_consumerReady;
+
+    // Pipeline counters
+    std::atomic<quint64> m_framesGrabbed;
+    std::atomic<quint64> m_framesRetrieved;
+    std::atomic<quint64> m_framesConverted;
+    std::atomic<quint64> m_framesDisplayed;
+    std::atomic<quint64> m_framesDropped;
+    std::atomic<quint64> m_reconnects;
+    std::atomic<qint64> m_timeToFirstFrameNs;
+    bool m_hasRun = false; // Capture thread only
     
-#ifdef OPENCV_ENABLED
-    cv::VideoCapture m_videoCapture;
-    // Convert OpenCV Mat to QImage
-    QImage matToQImage(const cv::Mat &mat) const;
-#endif
+    // Converts a frame for the current display transform (displaymapping.h)
+    QImage frameToQImage(const CaptureFrame &frame);
 };
 
 #endif // RTSPSTREAMER_H
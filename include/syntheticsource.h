@@ -0,0 +1,55 @@
+#ifndef SYNTHETICSOURCE_H
+#define SYNTHETICSOURCE_H
+
+#include "capturesource.h"
+#include <QElapsedTimer>
+#include <QPoint>
+#include <vector>
+
+// Generated frames for benchmarking and profiling without a camera.
+//
+// URL format: synthetic://WIDTHxHEIGHT[@FPS][/PATTERN][?gray]
+//   FPS      frames per second; 0 delivers frames as fast as they are taken
+//   PATTERN  bars (default), gradient or noise
+//   gray     produce 8-bit grayscale instead of BGR
+// e.g. synthetic://1920x1080@60, synthetic://1280x720@0/noise?gray
+class SyntheticSource : public CaptureSource
+{
+public:
+    enum Pattern {
+        Bars,
+        Gradient,
+        Noise
+    };
+
+    explicit SyntheticSource(const QString &url);
+
+    bool open() override;
+    void close() override;
+    bool grab() override;
+    bool retrieve(CaptureFrame &frame) override;
+    QSize frameSize() const override;
+
+private:
+    QSize m_size = QSize(1280, 720);
+    double m_fps = 30.0;
+    Pattern m_pattern = Bars;
+    int m_channels = 3;
+    bool m_valid = false;
+
+    std::vector<uchar> m_background; // Static part of the pattern
+    std::vector<uchar> m_frame;      // Background plus moving marker
+    QPoint m_markerPos;
+    quint64 m_frameIndex = 0;
+
+    QElapsedTimer m_clock;
+    qint64 m_nextFrameNs = 0;
+
+    int stride() const { return m_size.width() * m_channels; }
+    void renderBackground();
+    void moveMarker();
+    void fillRect(std::vector<uchar> &buffer, int x, int y, int w, int h, const uchar *bgr);
+    void copyRect(int x, int y, int w, int h);
+};
+
+#endif // SYNTHETICSOURCE_H
@@ -0,0 +1,52 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Single-producer/single-consumer triple buffer with latest-wins semantics.
+// The producer always owns one slot to fill, the consumer always owns one slot
+// to read, and the third slot is exchanged between them through an atomic
+// index, so neither side ever waits on the other.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : m_middle(1), m_back(0), m_front(2) {}
+
+    // Producer side: fill writeSlot(), then publish() it.
+    T &writeSlot() { return m_slots[m_back]; }
+
+    // Returns true if the previously published slot was never picked up
+    // by the consumer (i.e. it has just been overwritten).
+    bool publish()
+    {
+        int previous = m_middle.exchange(m_back | DirtyBit, std::memory_order_acq_rel);
+        m_back = previous & IndexMask;
+        return (previous & DirtyBit) != 0;
+    }
+
+    // Consumer side: take the newest published slot if there is one.
+    // Returns false if nothing new was published since the last call.
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & DirtyBit))
+            return false;
+
+        int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & IndexMask;
+        return true;
+    }
+
+    const T &readSlot() const { return m_slots[m_front]; }
+
+private:
+    static constexpr int IndexMask = 0x3;
+    static constexpr int DirtyBit = 0x4;
+
+    T m_slots[3];
+    std::atomic<int> m_middle;  // Shared slot index plus dirty flag
+    int m_back;                 // Owned by the producer
+    int m_front;                // Owned by the consumer
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,44 @@
+#ifndef VIDEOKERNEL_H
+#define VIDEOKERNEL_H
+
+#include <cstdint>
+
+// Fused per-pixel kernel for the video path: converts decoder output to
+// 32-bit 0xFFRRGGBB pixels (QImage::Format_RGB32), resamples it to the exact
+// output size (nearest neighbour, like Qt::FastTransformation) and optionally
+// rotates it by 180 degrees, all in a single pass over the destination.
+//
+// Vectorized with NEON on ARM64 and SSSE3/AVX2 on x86 (selected at runtime);
+// convertScaleRotateReference() is the plain scalar implementation the
+// vector paths must match pixel for pixel.
+class VideoKernel
+{
+public:
+    enum SourceFormat {
+        Bgr24,  // OpenCV CV_8UC3
+        Gray8   // OpenCV CV_8UC1
+    };
+
+    struct Source {
+        const uint8_t *data;  // First pixel of the (possibly cropped) region
+        int width;
+        int height;
+        int stride;           // Bytes per source row
+        SourceFormat format;
+    };
+
+    struct Target {
+        uint8_t *data;
+        int width;
+        int height;
+        int stride;           // Bytes per destination row
+    };
+
+    static void convertScaleRotate(const Source &src, const Target &dst, bool rotate180);
+    static void convertScaleRotateReference(const Source &src, const Target &dst, bool rotate180);
+
+    // Name of the vector backend picked for this CPU ("avx2", "neon", ...)
+    static const char *backendName();
+};
+
+#endif // VIDEOKERNEL_H
@@ -0,0 +1,64 @@
+#ifndef VIDEOWIDGET_H
+#define VIDEOWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QString>
+
+// Video surface that keeps a reference to the latest frame and paints it
+// straight from paintEvent(). Only the video rectangle is invalidated per
+// frame; the letterbox bars are repainted when the geometry changes.
+class VideoWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit VideoWidget(QWidget *parent = nullptr);
+
+    // Show a new frame. Returns false if the frame was skipped (same frame
+    // as the one on screen, or the widget isn't visible).
+    bool setFrame(const QImage &frame);
+
+    // Replace the video with a centred text message (e.g. connection errors)
+    void showMessage(const QString &message);
+
+    // Drop the current frame and message
+    void clear();
+
+    // Draw the message text rotated by 180 degrees to match the display
+    void setRotated180(bool rotated);
+
+    // Frame currently shown (null while a message is shown)
+    QImage currentFrame() const { return m_frame; }
+
+    // Area the current frame is drawn to, in widget coordinates
+    QRect videoRect() const { return m_videoRect; }
+
+    // Presentation statistics
+    quint64 paintedFrames() const { return m_paintedFrames; }
+    quint64 skippedFrames() const { return m_skippedFrames; }
+
+signals:
+    // Emitted once per frame accepted by setFrame(): painted is true when
+    // the frame reached the screen, false when it was replaced by a newer
+    // one before it could be painted. Rejected frames (hidden widget,
+    // repeats) aren't reported.
+    void framePresented(bool painted);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QImage m_frame;
+    QString m_message;
+    QRect m_videoRect;
+    bool m_framePending = false;
+    bool m_rotated180 = false;
+    quint64 m_paintedFrames = 0;
+    quint64 m_skippedFrames = 0;
+
+    void updateVideoRect();
+};
+
+#endif // VIDEOWIDGET_H
@@ -0,0 +1,256 @@
+#include "asynclogger.h"
+#include "boundedqueue.h"
+#include <QDateTime>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+const int MaxMessageBytes = 480;
+const int MaxCategoryBytes = 31;
+
+struct Record {
+    qint64 timestampMs;
+    QtMsgType type;
+    int length;
+    char category[MaxCategoryBytes + 1];
+    char text[MaxMessageBytes];
+};
+
+// Encodes UTF-16 into at most capacity bytes of UTF-8 without allocating,
+// never splitting a character; returns the number of bytes written
+int encodeUtf8(const QString &string, char *out, int capacity)
+{
+    const ushort *s = string.utf16();
+    const int size = string.size();
+    int length = 0;
+
+    for (int i = 0; i < size; ++i) {
+        uint c = s[i];
+        if (QChar::isHighSurrogate(c) && i + 1 < size && QChar::isLowSurrogate(s[i + 1]))
+            c = QChar::surrogateToUcs4(static_cast<ushort>(c), s[++i]);
+        else if (QChar::isSurrogate(c))
+            c = 0xFFFD;
+
+        char bytes[4];
+        int count;
+        if (c < 0x80) {
+            bytes[0] = static_cast<char>(c);
+            count = 1;
+        } else if (c < 0x800) {
+            bytes[0] = static_cast<char>(0xC0 | (c >> 6));
+            bytes[1] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 2;
+        } else if (c < 0x10000) {
+            bytes[0] = static_cast<char>(0xE0 | (c >> 12));
+            bytes[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes[2] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 3;
+        } else {
+            bytes[0] = static_cast<char>(0xF0 | (c >> 18));
+            bytes[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            bytes[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes[3] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 4;
+        }
+
+        if (length + count > capacity)
+            break; // Truncated
+        std::memcpy(out + length, bytes, static_cast<size_t>(count));
+        length += count;
+    }
+    return length;
+}
+
+const char *typeName(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return "DEBUG";
+    case QtInfoMsg:
+        return "INFO";
+    case QtWarningMsg:
+        return "WARNING";
+    case QtCriticalMsg:
+        return "CRITICAL";
+    case QtFatalMsg:
+        return "FATAL";
+    }
+    return "UNKNOWN";
+}
+
+void writeLine(qint64 timestampMs, QtMsgType type, const char *category, const char *text, int length)
+{
+    QByteArray timestamp = QDateTime::fromMSecsSinceEpoch(timestampMs)
+                               .toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1();
+    fprintf(stderr, "%s [%s] %s: %.*s\n", timestamp.constData(), typeName(type),
+            category ? category : "default", length, text);
+}
+
+class Logger
+{
+public:
+    Logger()
+        : m_ring(new Ring)
+    {
+        m_writer = QThread::create([this]() { run(); });
+        m_writer->start(QThread::LowPriority);
+    }
+
+    ~Logger()
+    {
+        m_running.store(false, std::memory_order_relaxed);
+        m_writer->wait();
+        delete m_writer;
+    }
+
+    // Any thread. Never blocks: drops the record if the ring is full.
+    void push(QtMsgType type, const QMessageLogContext &context, const QString &message)
+    {
+        bool queued = m_ring->emplace([&](Record &record) {
+            record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+            record.type = type;
+            const char *category = context.category ? context.category : "default";
+            qstrncpy(record.category, category, sizeof(record.category));
+            record.length = encodeUtf8(message, record.text, MaxMessageBytes);
+        });
+        if (!queued)
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Writes what is queued on the calling thread, ahead of a fatal message;
+    // gives up if the writer thread doesn't let go of the ring in time
+    void flush()
+    {
+        if (!m_drainMutex.tryLock(100))
+            return;
+        drain();
+        m_drainMutex.unlock();
+        fflush(stderr);
+    }
+
+    quint64 written() const { return m_written.load(std::memory_order_relaxed); }
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    typedef BoundedQueue<Record, AsyncLogger::Capacity> Ring;
+    std::unique_ptr<Ring> m_ring;   // About 2 MB, so not inline
+    QMutex m_drainMutex;            // Single consumer: the writer, or flush()
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<bool> m_running{true};
+    QThread *m_writer = nullptr;
+
+    // Writes all complete records; returns how many. Needs m_drainMutex.
+    int drain()
+    {
+        int count = 0;
+        while (m_ring->consume([](const Record &record) {
+            writeLine(record.timestampMs, record.type, record.category, record.text, record.length);
+        })) {
+            ++count;
+        }
+        m_written.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+        return count;
+    }
+
+    void run()
+    {
+        quint64 reportedDrops = 0;
+        bool running = true;
+        while (running) {
+            running = m_running.load(std::memory_order_relaxed);
+
+            m_drainMutex.lock();
+            int count = drain();
+            m_drainMutex.unlock();
+            quint64 drops = dropped();
+            if (drops != reportedDrops) {
+                QByteArray text = QByteArray::number(drops - reportedDrops) + " log records dropped (ring full)";
+                writeLine(QDateTime::currentMSecsSinceEpoch(), QtWarningMsg, "kria.log",
+                          text.constData(), text.size());
+                reportedDrops = drops;
+            }
+
+            if (count > 0) {
+                fflush(stderr);
+            } else if (running) {
+                // Nothing queued: batch up whatever arrives in the meantime
+                QThread::msleep(5);
+            }
+        }
+    }
+};
+
+std::atomic<Logger*> s_logger(nullptr);
+
+void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Logger *logger = s_logger.load(std::memory_order_acquire);
+
+    if (type == QtFatalMsg || !logger) {
+        // Qt aborts right after a fatal message: write it synchronously,
+        // after the queued lines that led up to it
+        if (logger)
+            logger->flush();
+        QByteArray text = message.toUtf8();
+        writeLine(QDateTime::currentMSecsSinceEpoch(), type, context.category, text.constData(), text.size());
+        fflush(stderr);
+        return;
+    }
+
+    logger->push(type, context, message);
+}
+
+} // namespace
+
+void AsyncLogger::install()
+{
+    if (s_logger.load())
+        return;
+
+    s_logger.store(new Logger, std::memory_order_release);
+    qInstallMessageHandler(messageHandler);
+}
+
+void AsyncLogger::shutdown()
+{
+    Logger *logger = s_logger.exchange(nullptr);
+    qInstallMessageHandler(nullptr);
+    delete logger;
+}
+
+bool AsyncLogger::setMinimumLevel(const QString &level)
+{
+    QString rules;
+    if (level == "debug") {
+        rules = "*.debug=true";
+    } else if (level == "info") {
+        rules = "*.debug=false";
+    } else if (level == "warning") {
+        rules = "*.debug=false\n*.info=false";
+    } else if (level == "critical") {
+        rules = "*.debug=false\n*.info=false\n*.warning=false";
+    } else {
+        return false;
+    }
+    QLoggingCategory::setFilterRules(rules);
+    return true;
+}
+
+quint64 AsyncLogger::writtenRecords()
+{
+    Logger *logger = s_logger.load(std::memory_order_acquire);
+    return logger ? logger->written() : 0;
+}
+
+quint64 AsyncLogger::droppedRecords()
+{
+    Logger *logger = s_logger.load(std::memory_order_acquire);
+    return logger ? logger->dropped() : 0;
+}
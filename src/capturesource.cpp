@@ -0,0 +1,34 @@
+#include "capturesource.h"
+#include "syntheticsource.h"
+#include "filereplaysource.h"
+#include "opencvcapturesource.h"
+
+std::unique_ptr<CaptureSource> CaptureSource::create(const QString &url)
+{
+    if (url.startsWith("synthetic://", Qt::CaseInsensitive))
+        return std::unique_ptr<CaptureSource>(new SyntheticSource(url));
+
+    if (url.startsWith("file://", Qt::CaseInsensitive))
+        return FileReplaySource::create(url);
+
+#ifdef OPENCV_ENABLED
+    return std::unique_ptr<CaptureSource>(new OpenCvCaptureSource(url));
+#else
+    return nullptr;
+#endif
+}
+
+bool CaptureSource::supportsUrl(const QString &url)
+{
+    if (url.startsWith("synthetic://", Qt::CaseInsensitive))
+        return true;
+
+    if (url.startsWith("file://", Qt::CaseInsensitive))
+        return FileReplaySource::supportsUrl(url);
+
+#ifdef OPENCV_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
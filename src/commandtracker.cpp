@@ -0,0 +1,144 @@
+#include "commandtracker.h"
+#include <cstring>
+
+CommandTracker::CommandTracker()
+{
+}
+
+void CommandTracker::sent(ControlProtocol::MessageType type, quint32 sequence, const char *data, int size,
+                          bool reliable, qint64 nowNs)
+{
+    if (size > MaxCommandSize)
+        return;
+
+    Command *slot = nullptr;
+    Command *oldest = nullptr;
+    for (Command &command : m_commands) {
+        if (!command.active) {
+            if (!slot)
+                slot = &command;
+            continue;
+        }
+        // Only the newest state matters, so stop resending the old one
+        if (command.reliable && command.type == type) {
+            command.active = false;
+            if (!slot)
+                slot = &command;
+            continue;
+        }
+        if (!oldest || command.lastSentNs < oldest->lastSentNs)
+            oldest = &command;
+    }
+
+    if (!slot) {
+        // Table full: the oldest command is long overdue, count it as lost
+        slot = oldest;
+        ++m_lost;
+        recordOutcome(true);
+    }
+
+    slot->active = true;
+    slot->reliable = reliable;
+    slot->type = type;
+    slot->sequence = sequence;
+    slot->attempts = 1;
+    slot->lastSentNs = nowNs;
+    slot->deadlineNs = nowNs + (reliable ? retransmitTimeoutNs(1) : LossTimeoutNs);
+    slot->size = size;
+    std::memcpy(slot->data, data, static_cast<size_t>(size));
+}
+
+qint64 CommandTracker::acknowledged(quint32 sequence, qint64 echoedSentNs, qint64 nowNs)
+{
+    for (Command &command : m_commands) {
+        if (command.active && command.sequence == sequence) {
+            qint64 rtt = nowNs - echoedSentNs;
+            resolve(command, rtt);
+            return rtt;
+        }
+    }
+    return -1;
+}
+
+qint64 CommandTracker::acknowledged(const char *data, int size, qint64 nowNs)
+{
+    Command *match = nullptr;
+    for (Command &command : m_commands) {
+        if (command.active && command.size == size && std::memcmp(command.data, data, static_cast<size_t>(size)) == 0
+            && (!match || command.sequence < match->sequence)) {
+            match = &command;
+        }
+    }
+    if (!match)
+        return -1;
+
+    qint64 rtt = match->attempts == 1 ? nowNs - match->lastSentNs : -1;
+    resolve(*match, rtt);
+    return rtt;
+}
+
+CommandTracker::Command *CommandTracker::nextRetransmission(qint64 nowNs)
+{
+    for (Command &command : m_commands) {
+        if (!command.active || command.deadlineNs > nowNs)
+            continue;
+
+        // The last transmission went unanswered
+        recordOutcome(true);
+
+        if (!command.reliable || command.attempts >= MaxAttempts) {
+            command.active = false;
+            ++m_lost;
+            if (command.reliable)
+                ++m_failed;
+            continue;
+        }
+
+        ++command.attempts;
+        ++m_retransmissions;
+        command.lastSentNs = nowNs;
+        command.deadlineNs = nowNs + retransmitTimeoutNs(command.attempts);
+        return &command;
+    }
+    return nullptr;
+}
+
+qint64 CommandTracker::nextDeadlineNs() const
+{
+    qint64 deadline = 0;
+    for (const Command &command : m_commands) {
+        if (command.active && (deadline == 0 || command.deadlineNs < deadline))
+            deadline = command.deadlineNs;
+    }
+    return deadline;
+}
+
+qint64 CommandTracker::retransmitTimeoutNs(int attempts) const
+{
+    qint64 timeout = m_smoothedRttNs > 0 ? 2 * m_smoothedRttNs : InitialRetransmitNs;
+    if (timeout < MinRetransmitNs)
+        timeout = MinRetransmitNs;
+    // Double per attempt
+    for (int i = 1; i < attempts && timeout < MaxRetransmitNs; ++i)
+        timeout *= 2;
+    return timeout < MaxRetransmitNs ? timeout : MaxRetransmitNs;
+}
+
+void CommandTracker::resolve(Command &command, qint64 rttNs)
+{
+    command.active = false;
+    ++m_acks;
+    recordOutcome(false);
+
+    if (rttNs < 0)
+        return;
+    m_rtt.record(rttNs);
+    // Same smoothing as TCP's SRTT (RFC 6298)
+    m_smoothedRttNs = m_smoothedRttNs == 0 ? rttNs : (7 * m_smoothedRttNs + rttNs) / 8;
+}
+
+void CommandTracker::recordOutcome(bool lost)
+{
+    const double weight = 1.0 / 16;
+    m_lossRate += weight * ((lost ? 1.0 : 0.0) - m_lossRate);
+}
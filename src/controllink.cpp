@@ -0,0 +1,1041 @@
+#include "controllink.h"
+#include "monotonicclock.h"
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QThread>
+#include <QRandomGenerator>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+Q_LOGGING_CATEGORY(controlLink, "kria.controllink")
+
+ControlLink::ControlLink(QObject *parent)
+    : QObject(parent)
+    , m_drainPending(false)
+    , m_reportCommands(false)
+    , m_stopRequested(false)
+    , m_stopRequestedNs(0)
+    , m_udpSocket(nullptr)
+    , m_telemetrySocket(nullptr)
+    , m_tcpClient(nullptr)
+    , m_reconnectTimer(nullptr)
+    , m_retransmitTimer(nullptr)
+    , m_flushTimer(nullptr)
+    , m_serverAddress("192.168.1.71")
+    , m_serverHost(m_serverAddress)
+    , m_udpPort(8556)
+    , m_tcpPort(8555)
+    , m_telemetryPort(0)
+    , m_udpEnabled(true)
+    , m_tcpEnabled(false)
+    , m_autoReconnect(true)
+    , m_protocolFormat(ControlProtocol::Text)
+    , m_textSequence(0)
+    , m_stopSequence(0)
+    , m_stopUnacknowledged(false)
+    , m_batchSize(0)
+    , m_batchCount(0)
+    , m_batchLatencyNs(0)
+    , m_tcpQueueCount(0)
+    , m_reconnectAttempts(0)
+    , m_tcpDownSinceNs(0)
+    , m_tcpReadSize(0)
+    , m_scanNotifyPending(false)
+    , m_udpBytesSent(0)
+    , m_tcpBytesSent(0)
+    , m_sendErrors(0)
+    , m_tcpReconnects(0)
+    , m_queueOverflows(0)
+    , m_stopCommands(0)
+    , m_preempted(0)
+    , m_batches(0)
+    , m_batchedCommands(0)
+    , m_tcpQueueDepth(0)
+    , m_tcpQueueDropped(0)
+    , m_tcpReplayed(0)
+    , m_tcpReconnectNs(0)
+    , m_acks(0)
+    , m_lost(0)
+    , m_retransmissions(0)
+    , m_smoothedRttNs(0)
+    , m_lossRate(0.0)
+    , m_scansReceived(0)
+    , m_scansMalformed(0)
+{
+    // Children move to the link thread together with this object
+
+    // Bound implicitly by the first send; the server's ACKs and telemetry
+    // come back to it
+    m_udpSocket = new QUdpSocket(this);
+    connect(m_udpSocket, &QUdpSocket::readyRead, this, &ControlLink::onUdpReadyRead);
+
+    // Bound by setTelemetryPort() for servers that stream to a fixed port
+    m_telemetrySocket = new QUdpSocket(this);
+    connect(m_telemetrySocket, &QUdpSocket::readyRead, this, &ControlLink::onUdpReadyRead);
+
+    m_tcpClient = new QTcpSocket(this);
+    connect(m_tcpClient, &QTcpSocket::connected, this, &ControlLink::onTcpConnected);
+    connect(m_tcpClient, &QTcpSocket::disconnected, this, &ControlLink::onTcpDisconnected);
+    connect(m_tcpClient, &QTcpSocket::errorOccurred, this, &ControlLink::onTcpError);
+    connect(m_tcpClient, &QTcpSocket::bytesWritten, this, &ControlLink::onTcpBytesWritten);
+    connect(m_tcpClient, &QTcpSocket::readyRead, this, &ControlLink::onTcpReadyRead);
+
+    // Started with a backoff delay by scheduleReconnect()
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &ControlLink::reconnectToServer);
+
+    // Fires at the next retransmission or loss deadline of a tracked command
+    m_retransmitTimer = new QTimer(this);
+    m_retransmitTimer->setSingleShot(true);
+    m_retransmitTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_retransmitTimer, &QTimer::timeout, this, &ControlLink::onRetransmitTimeout);
+
+    // Sends a held batch once its oldest command reaches the batch latency
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_flushTimer, &QTimer::timeout, this, &ControlLink::flushBatch);
+}
+
+bool ControlLink::post(const ControlCommand &command, bool wake)
+{
+    if (!m_queue.push(command)) {
+        m_queueOverflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (wake)
+        this->wake();
+    return true;
+}
+
+void ControlLink::wake()
+{
+    // One wake-up per batch: only post an event if none is pending
+    if (!m_drainPending.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &ControlLink::drain, Qt::QueuedConnection);
+}
+
+void ControlLink::emergencyStop()
+{
+    m_stopRequestedNs.store(MonotonicClock::timestampNs(), std::memory_order_relaxed);
+    m_stopRequested.store(true, std::memory_order_release);
+    wake();
+}
+
+const RadarScan *ControlLink::takeScan()
+{
+    // Re-arm the notification before taking the slot so a scan published
+    // right after this point triggers a new scanReady()
+    m_scanNotifyPending.store(false, std::memory_order_release);
+    if (!m_scans.update())
+        return nullptr;
+    return &m_scans.readSlot();
+}
+
+ControlLink::Priority ControlLink::priority(ControlProtocol::MessageType type)
+{
+    switch (type) {
+    case ControlProtocol::StopMessage:
+        return EmergencyPriority;
+    case ControlProtocol::ModeMessage:
+    case ControlProtocol::StateMessage:
+        return StatePriority;
+    case ControlProtocol::ButtonMessage:
+    case ControlProtocol::TouchMessage:
+        return MotionPriority;
+    default:
+        return TelemetryPriority;
+    }
+}
+
+void ControlLink::drain()
+{
+    // Re-arm before popping so a command posted meanwhile triggers a new drain
+    m_drainPending.store(false, std::memory_order_release);
+
+    bool stopped = m_stopRequested.load(std::memory_order_acquire);
+    qint64 stopNs = m_stopRequestedNs.load(std::memory_order_relaxed);
+    if (stopped)
+        sendEmergencyStop();
+
+    int count = 0;
+    while (count < static_cast<int>(QueueCapacity) && m_queue.pop(m_drained[count]))
+        ++count;
+    if (count == static_cast<int>(QueueCapacity))
+        wake(); // There may be more
+
+    // The commands of one Batch were posted together on purpose (TOUCH
+    // then MODE for a tap): they keep their order and go out at the class
+    // of their highest member
+    for (int i = 0; i < count;) {
+        int end = i + 1;
+        int rank = priority(m_drained[i].type);
+        if (m_drained[i].group != 0) {
+            while (end < count && m_drained[end].group == m_drained[i].group)
+                rank = qMin(rank, static_cast<int>(priority(m_drained[end++].type)));
+        }
+        for (; i < end; ++i)
+            m_drainedClass[i] = static_cast<quint8>(rank);
+    }
+
+    // Higher classes first, so a burst of motion commands can't delay a
+    // mode change; posting order within a class
+    bool flushNow = m_batchLatencyNs == 0;
+    for (int rank = EmergencyPriority; rank < PriorityCount; ++rank) {
+        for (int i = 0; i < count; ++i) {
+            if (m_drainedClass[i] != rank)
+                continue;
+            const ControlCommand &command = m_drained[i];
+            // Motion queued before a stop would undo it
+            if (stopped && command.queuedNs <= stopNs && isMotion(command)) {
+                m_preempted.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            send(command);
+            flushNow = flushNow || isReliable(command);
+            if (m_batchLatencyNs < 0)
+                flushBatch();
+        }
+    }
+
+    if (m_batchCount == 0)
+        return;
+
+    if (flushNow) {
+        flushBatch();
+    } else if (!m_flushTimer->isActive()) {
+        qint64 delayNs = m_batchEntries[0].queuedNs + m_batchLatencyNs - MonotonicClock::timestampNs();
+        m_flushTimer->start(static_cast<int>(qMax<qint64>(0, (delayNs + 999999) / 1000000)));
+    }
+}
+
+void ControlLink::sendEmergencyStop()
+{
+    if (!m_stopRequested.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    // A held batch only ever holds unreliable motion and ticks, since
+    // reliable commands flush at once; queued TCP motion and moving input
+    // state would undo the stop as well. The release edge that follows the
+    // stop becomes the first state after it.
+    quint64 preempted = static_cast<quint64>(m_batchCount);
+    m_batchCount = 0;
+    m_batchSize = 0;
+    m_flushTimer->stop();
+    for (int i = m_tcpQueueCount - 1; i >= 0; --i) {
+        if (m_tcpQueue[i].motion) {
+            removeTcpQueued(i, 1);
+            ++preempted;
+        }
+    }
+    m_preempted.fetch_add(preempted, std::memory_order_relaxed);
+
+    bool binary = m_protocolFormat == ControlProtocol::Binary;
+    const char *data;
+    int size;
+    quint32 sequence;
+    if (binary) {
+        size = m_protocol.encodeStop();
+        data = m_protocol.data();
+        sequence = m_protocol.sequence();
+    } else {
+        data = "STOP\n";
+        size = 4;
+        sequence = ++m_textSequence;
+    }
+
+    qint64 now = MonotonicClock::timestampNs();
+    m_inputToWire.record(now - m_stopRequestedNs.load(std::memory_order_relaxed));
+    m_stopCommands.fetch_add(1, std::memory_order_relaxed);
+
+    // Over every enabled transport, so either one getting through stops
+    // the robot; retransmitted over UDP until acknowledged on either
+    m_stopSequence = sequence;
+    m_stopUnacknowledged = true;
+    if (m_udpEnabled && sendUdpData(data, size)) {
+        m_tracker.sent(ControlProtocol::StopMessage, sequence, data, size, true, now);
+        scheduleRetransmit();
+    }
+
+    int tcpSize = binary ? size : size + 1;
+    if (m_tcpClient->state() == QTcpSocket::ConnectedState) {
+        // Ahead of the queue; only what Qt has buffered already goes first
+        sendTcpData(data, tcpSize);
+    } else if (m_tcpEnabled) {
+        queueTcpCommand(data, tcpSize, ControlProtocol::StopMessage, binary, false);
+    }
+
+    qCWarning(controlLink) << "Emergency stop sent";
+    if (m_reportCommands.load(std::memory_order_relaxed))
+        emit commandSent(QStringLiteral("STOP"));
+}
+
+void ControlLink::start()
+{
+    if (m_tcpEnabled) {
+        connectToServer();
+    }
+}
+
+void ControlLink::stop()
+{
+    flushBatch();
+    m_reconnectTimer->stop();
+    m_retransmitTimer->stop();
+
+    if (m_tcpClient->state() == QTcpSocket::ConnectedState) {
+        m_tcpClient->disconnectFromHost();
+    }
+}
+
+void ControlLink::setServerAddress(const QString &address)
+{
+    m_serverAddress = address;
+    // Parsed once here instead of on every send
+    m_serverHost = QHostAddress(address);
+}
+
+void ControlLink::setTelemetryPort(quint16 port)
+{
+    if (port == m_telemetryPort)
+        return;
+
+    m_telemetryPort = port;
+    m_telemetrySocket->close();
+    if (port == 0)
+        return;
+
+    if (m_telemetrySocket->bind(QHostAddress::AnyIPv4, port))
+        qCDebug(controlLink) << "Receiving telemetry on UDP port" << port;
+    else
+        emit errorOccurred(QString("Cannot receive telemetry on UDP port %1: %2")
+                               .arg(port).arg(m_telemetrySocket->errorString()));
+}
+
+void ControlLink::setUdpPort(quint16 port)
+{
+    m_udpPort = port;
+}
+
+void ControlLink::setTcpPort(quint16 port)
+{
+    m_tcpPort = port;
+}
+
+void ControlLink::setUdpEnabled(bool enabled)
+{
+    flushBatch();
+    m_udpEnabled = enabled;
+}
+
+void ControlLink::setTcpEnabled(bool enabled)
+{
+    flushBatch();
+    m_tcpEnabled = enabled;
+    if (!enabled)
+        clearTcpQueue();
+    if (enabled && m_tcpClient->state() == QTcpSocket::UnconnectedState) {
+        connectToServer();
+    } else if (!enabled && m_tcpClient->state() == QTcpSocket::ConnectedState) {
+        m_tcpClient->disconnectFromHost();
+    }
+}
+
+void ControlLink::setProtocolFormat(ControlProtocol::Format format)
+{
+    // A batch holds one format only, and so does the TCP stream
+    flushBatch();
+    if (format != m_protocolFormat)
+        clearTcpQueue();
+    m_protocolFormat = format;
+}
+
+void ControlLink::setBatchLatency(int ms)
+{
+    m_batchLatencyNs = ms < 0 ? -1 : static_cast<qint64>(ms) * 1000000;
+    flushBatch();
+}
+
+void ControlLink::setRealtimePriority(bool enabled)
+{
+#ifdef Q_OS_LINUX
+    const int RealtimePriority = 10; // Above other SCHED_FIFO defaults, below kernel threads
+    sched_param param;
+    param.sched_priority = enabled ? RealtimePriority : 0;
+    int error = pthread_setschedparam(pthread_self(), enabled ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (error != 0) {
+        qCWarning(controlLink) << "Cannot set real-time priority:" << strerror(error)
+                               << "(needs CAP_SYS_NICE or an rtprio limit)";
+        return;
+    }
+#else
+    QThread::currentThread()->setPriority(enabled ? QThread::TimeCriticalPriority : QThread::NormalPriority);
+#endif
+    qCInfo(controlLink) << "Control link real-time priority" << (enabled ? "enabled" : "disabled");
+}
+
+void ControlLink::setReportCommands(bool enabled)
+{
+    m_reportCommands.store(enabled, std::memory_order_relaxed);
+}
+
+void ControlLink::fillStats(ControllerStats &stats) const
+{
+    stats.udpBytesSent = m_udpBytesSent.load(std::memory_order_relaxed);
+    stats.tcpBytesSent = m_tcpBytesSent.load(std::memory_order_relaxed);
+    stats.sendErrors = m_sendErrors.load(std::memory_order_relaxed);
+    stats.tcpReconnects = m_tcpReconnects.load(std::memory_order_relaxed);
+    stats.queueOverflows = m_queueOverflows.load(std::memory_order_relaxed);
+    stats.stopCommands = m_stopCommands.load(std::memory_order_relaxed);
+    stats.preemptedCommands = m_preempted.load(std::memory_order_relaxed);
+    stats.batches = m_batches.load(std::memory_order_relaxed);
+    stats.batchedCommands = m_batchedCommands.load(std::memory_order_relaxed);
+    stats.tcpQueueDepth = m_tcpQueueDepth.load(std::memory_order_relaxed);
+    stats.tcpQueueDropped = m_tcpQueueDropped.load(std::memory_order_relaxed);
+    stats.tcpReplayed = m_tcpReplayed.load(std::memory_order_relaxed);
+    stats.tcpReconnectNs = m_tcpReconnectNs.load(std::memory_order_relaxed);
+    stats.acksReceived = m_acks.load(std::memory_order_relaxed);
+    stats.commandsLost = m_lost.load(std::memory_order_relaxed);
+    stats.retransmissions = m_retransmissions.load(std::memory_order_relaxed);
+    stats.smoothedRttNs = m_smoothedRttNs.load(std::memory_order_relaxed);
+    stats.lossRate = m_lossRate.load(std::memory_order_relaxed);
+    stats.scansReceived = m_scansReceived.load(std::memory_order_relaxed);
+    stats.scansMalformed = m_scansMalformed.load(std::memory_order_relaxed);
+}
+
+bool ControlLink::isReliable(const ControlCommand &command)
+{
+    // Mode changes alter the server's state and must arrive, and so must the
+    // input edges: a lost release would leave the robot moving until the
+    // next press. Ticks and one-shot directional and touch commands are
+    // superseded within milliseconds, so resending them would only add
+    // stale input.
+    return command.type == ControlProtocol::ModeMessage
+        || (command.type == ControlProtocol::StateMessage && command.edge);
+}
+
+bool ControlLink::isMotion(const ControlCommand &command)
+{
+    // Hold-to-move travels as STATE samples: those with a direction held or
+    // the stick off center move the robot just like BUTTON and TOUCH
+    if (command.type == ControlProtocol::StateMessage)
+        return command.directions != 0 || command.axisX != 0 || command.axisY != 0;
+    return priority(command.type) >= MotionPriority;
+}
+
+void ControlLink::send(const ControlCommand &command)
+{
+    if (m_protocolFormat == ControlProtocol::Binary) {
+        switch (command.type) {
+        case ControlProtocol::ButtonMessage: {
+            ControlProtocol::ButtonCode code = ControlProtocol::buttonCode(command.button);
+            if (code == ControlProtocol::UnknownButton) {
+                qCWarning(controlLink) << "No binary code for button" << command.button;
+                break;
+            }
+            sendMessage(m_protocol.encodeButton(code), command);
+            break;
+        }
+        case ControlProtocol::TouchMessage:
+            sendMessage(m_protocol.encodeTouch(command.x, command.y), command);
+            break;
+        case ControlProtocol::ModeMessage:
+            sendMessage(m_protocol.encodeMode(command.autoMode), command);
+            break;
+        case ControlProtocol::StateMessage:
+            sendMessage(m_protocol.encodeState(command.directions, command.axisX, command.axisY, command.edge),
+                        command);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    switch (command.type) {
+    case ControlProtocol::ButtonMessage:
+        sendCommand(QString("BUTTON:%1").arg(QLatin1String(command.button)), command);
+        break;
+    case ControlProtocol::TouchMessage:
+        sendCommand(QString("TOUCH:%1:%2").arg(command.x).arg(command.y), command);
+        break;
+    case ControlProtocol::ModeMessage:
+        sendCommand(QString("MODE:%1").arg(command.autoMode ? "AUTO" : "MANUAL"), command);
+        break;
+    case ControlProtocol::StateMessage:
+        sendCommand(stateCommand(command), command);
+        break;
+    default:
+        break;
+    }
+}
+
+QString ControlLink::stateCommand(const ControlCommand &command)
+{
+    // STATE:<directions joined by '+', or NONE>:<x>:<y>, axes as -1..1
+    QString directions;
+    static const quint8 Bits[] = { 0x01, 0x02, 0x04, 0x08 };
+    static const char *const Names[] = { "UP", "DOWN", "LEFT", "RIGHT" };
+    for (int i = 0; i < 4; ++i) {
+        if (command.directions & Bits[i]) {
+            if (!directions.isEmpty())
+                directions += '+';
+            directions += QLatin1String(Names[i]);
+        }
+    }
+    if (directions.isEmpty())
+        directions = QStringLiteral("NONE");
+
+    return QString("STATE:%1:%2:%3")
+        .arg(directions)
+        .arg(command.axisX / 32767.0, 0, 'f', 3)
+        .arg(command.axisY / 32767.0, 0, 'f', 3);
+}
+
+void ControlLink::sendCommand(const QString &command, const ControlCommand &source)
+{
+    // Newline terminated: needed over TCP and between the commands of a batch
+    QByteArray data = (command + "\n").toUtf8();
+    addToBatch(data.constData(), data.size(), true, ++m_textSequence, source);
+
+    if (m_reportCommands.load(std::memory_order_relaxed))
+        emit commandSent(command);
+}
+
+void ControlLink::sendMessage(int size, const ControlCommand &source)
+{
+    addToBatch(m_protocol.data(), size, false, m_protocol.sequence(), source);
+
+    if (m_reportCommands.load(std::memory_order_relaxed))
+        emit commandSent(QString("#%1").arg(m_protocol.sequence()));
+}
+
+void ControlLink::addToBatch(const char *data, int size, bool text, quint32 sequence, const ControlCommand &source)
+{
+    if (m_batchCount == MaxBatchCommands || m_batchSize + size > MaxBatchBytes)
+        flushBatch();
+    if (size > MaxBatchBytes) {
+        qCWarning(controlLink) << "Command of" << size << "bytes is too long to send";
+        return;
+    }
+
+    BatchEntry &entry = m_batchEntries[m_batchCount++];
+    entry.offset = BatchReserve + m_batchSize;
+    entry.size = text ? size - 1 : size;
+    entry.sequence = sequence;
+    entry.type = source.type;
+    entry.reliable = isReliable(source);
+    entry.motion = isMotion(source);
+    entry.queuedNs = source.queuedNs;
+    std::memcpy(m_batch + entry.offset, data, static_cast<size_t>(size));
+    m_batchSize += size;
+}
+
+void ControlLink::flushBatch()
+{
+    m_flushTimer->stop();
+    if (m_batchCount == 0)
+        return;
+
+    bool binary = m_protocolFormat == ControlProtocol::Binary;
+    char *commands = m_batch + BatchReserve;
+    qint64 now = MonotonicClock::timestampNs();
+
+    // Send times are set now, so a held message's RTT doesn't include the
+    // time it waited for the batch
+    if (binary) {
+        for (int i = 0; i < m_batchCount; ++i)
+            ControlProtocol::stamp(m_batch + m_batchEntries[i].offset, now);
+    }
+
+    const char *data;
+    qint64 size;
+    qint64 udpSize;
+    if (m_batchCount == 1) {
+        // A lone command goes out exactly as without batching; text UDP
+        // commands have no newline
+        data = commands;
+        size = m_batchSize;
+        udpSize = binary ? size : m_batchEntries[0].size;
+    } else {
+        int headerSize;
+        if (binary) {
+            headerSize = ControlProtocol::BatchHeaderSize;
+            ControlProtocol::writeBatchHeader(commands - headerSize, static_cast<quint16>(m_batchCount), m_batchSize);
+        } else {
+            // BATCH:<count>, then the newline terminated commands
+            char header[16];
+            headerSize = std::snprintf(header, sizeof(header), "BATCH:%d\n", m_batchCount);
+            std::memcpy(commands - headerSize, header, static_cast<size_t>(headerSize));
+        }
+        data = commands - headerSize;
+        size = udpSize = m_batchSize + headerSize;
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+        m_batchedCommands.fetch_add(static_cast<quint64>(m_batchCount), std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < m_batchCount; ++i)
+        m_inputToWire.record(now - m_batchEntries[i].queuedNs);
+
+    if (m_udpEnabled && sendUdpData(data, udpSize)) {
+        // Tracked one by one: the server acknowledges each command
+        for (int i = 0; i < m_batchCount; ++i) {
+            const BatchEntry &entry = m_batchEntries[i];
+            m_tracker.sent(entry.type, entry.sequence, m_batch + entry.offset, entry.size, entry.reliable, now);
+        }
+        scheduleRetransmit();
+    }
+
+    if (m_tcpEnabled) {
+        if (tcpWritable()) {
+            sendTcpData(data, size);
+        } else {
+            // Queued command by command, so superseded ones can be dropped
+            for (int i = 0; i < m_batchCount; ++i) {
+                const BatchEntry &entry = m_batchEntries[i];
+                queueTcpCommand(m_batch + entry.offset, binary ? entry.size : entry.size + 1, entry.type, binary, entry.motion);
+            }
+        }
+    }
+
+    m_batchCount = 0;
+    m_batchSize = 0;
+}
+
+bool ControlLink::sendUdpData(const char *data, qint64 size)
+{
+    if (m_serverHost.isNull()) {
+        qCDebug(controlLink) << "Cannot send UDP command: no server address";
+        return false;
+    }
+
+    qint64 bytesWritten = m_udpSocket->writeDatagram(data, size, m_serverHost, m_udpPort);
+
+    if (bytesWritten == -1) {
+        m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(controlLink) << "Failed to send UDP command:" << m_udpSocket->errorString();
+        return false;
+    }
+
+    m_udpBytesSent.fetch_add(static_cast<quint64>(bytesWritten), std::memory_order_relaxed);
+    return true;
+}
+
+void ControlLink::sendTcpData(const char *data, qint64 size)
+{
+    if (m_tcpClient->state() != QTcpSocket::ConnectedState) {
+        qCDebug(controlLink) << "Cannot send TCP command: not connected to server";
+        return;
+    }
+
+    qint64 bytesWritten = m_tcpClient->write(data, size);
+
+    if (bytesWritten == -1) {
+        m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(controlLink) << "Failed to send TCP command:" << m_tcpClient->errorString();
+    } else {
+        m_tcpBytesSent.fetch_add(static_cast<quint64>(bytesWritten), std::memory_order_relaxed);
+    }
+}
+
+bool ControlLink::tcpWritable() const
+{
+    // Behind queued commands, or with Qt's buffer backed up, a write would
+    // only add to the backlog
+    return m_tcpQueueCount == 0
+        && m_tcpClient->state() == QTcpSocket::ConnectedState
+        && m_tcpClient->bytesToWrite() < TcpHighWaterBytes;
+}
+
+void ControlLink::queueTcpCommand(const char *data, int size, ControlProtocol::MessageType type, bool binary, bool motion)
+{
+    if (size > MaxTcpCommandSize) {
+        qCWarning(controlLink) << "Command of" << size << "bytes is too long to queue for TCP";
+        return;
+    }
+
+    // Only the newest stop, mode, input state and direction matter
+    if (type == ControlProtocol::StopMessage || type == ControlProtocol::ModeMessage
+        || type == ControlProtocol::StateMessage || type == ControlProtocol::ButtonMessage) {
+        for (int i = m_tcpQueueCount - 1; i >= 0; --i) {
+            if (m_tcpQueue[i].type == type) {
+                removeTcpQueued(i, 1);
+                m_tcpQueueDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Full: drop the oldest command of the lowest class, or this one if it
+    // ranks below everything queued
+    Priority rank = priority(type);
+    if (m_tcpQueueCount == TcpQueueCapacity) {
+        m_tcpQueueDropped.fetch_add(1, std::memory_order_relaxed);
+        Priority lowest = priority(m_tcpQueue[m_tcpQueueCount - 1].type);
+        if (rank > lowest)
+            return;
+        int oldest = m_tcpQueueCount - 1;
+        while (oldest > 0 && priority(m_tcpQueue[oldest - 1].type) == lowest)
+            --oldest;
+        removeTcpQueued(oldest, 1);
+    }
+
+    // Kept in class order, oldest first within a class
+    int index = m_tcpQueueCount;
+    while (index > 0 && priority(m_tcpQueue[index - 1].type) > rank)
+        --index;
+    std::memmove(m_tcpQueue + index + 1, m_tcpQueue + index,
+                 static_cast<size_t>(m_tcpQueueCount - index) * sizeof(TcpPending));
+    ++m_tcpQueueCount;
+
+    TcpPending &pending = m_tcpQueue[index];
+    std::memcpy(pending.data, data, static_cast<size_t>(size));
+    pending.size = size;
+    pending.type = type;
+    pending.binary = binary;
+    pending.motion = motion;
+    m_tcpQueueDepth.store(static_cast<quint64>(m_tcpQueueCount), std::memory_order_relaxed);
+}
+
+void ControlLink::sendTcpQueue()
+{
+    if (m_tcpClient->state() != QTcpSocket::ConnectedState)
+        return;
+
+    qint64 now = MonotonicClock::timestampNs();
+    int sent = 0;
+    while (sent < m_tcpQueueCount && m_tcpClient->bytesToWrite() < TcpHighWaterBytes) {
+        TcpPending &pending = m_tcpQueue[sent++];
+        if (pending.binary)
+            ControlProtocol::stamp(pending.data, now);
+        sendTcpData(pending.data, pending.size);
+    }
+    removeTcpQueued(0, sent);
+}
+
+void ControlLink::removeTcpQueued(int index, int count)
+{
+    if (count <= 0)
+        return;
+    std::memmove(m_tcpQueue + index, m_tcpQueue + index + count,
+                 static_cast<size_t>(m_tcpQueueCount - index - count) * sizeof(TcpPending));
+    m_tcpQueueCount -= count;
+    m_tcpQueueDepth.store(static_cast<quint64>(m_tcpQueueCount), std::memory_order_relaxed);
+}
+
+void ControlLink::clearTcpQueue()
+{
+    m_tcpQueueDropped.fetch_add(static_cast<quint64>(m_tcpQueueCount), std::memory_order_relaxed);
+    removeTcpQueued(0, m_tcpQueueCount);
+}
+
+void ControlLink::onTcpBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes)
+    sendTcpQueue();
+}
+
+void ControlLink::scheduleRetransmit()
+{
+    qint64 deadline = m_tracker.nextDeadlineNs();
+    if (deadline == 0) {
+        m_retransmitTimer->stop();
+        return;
+    }
+
+    qint64 delayNs = deadline - MonotonicClock::timestampNs();
+    m_retransmitTimer->start(static_cast<int>(qMax<qint64>(0, (delayNs + 999999) / 1000000)));
+}
+
+void ControlLink::publishLinkQuality()
+{
+    m_acks.store(m_tracker.acks(), std::memory_order_relaxed);
+    m_lost.store(m_tracker.lost(), std::memory_order_relaxed);
+    m_retransmissions.store(m_tracker.retransmissions(), std::memory_order_relaxed);
+    m_smoothedRttNs.store(m_tracker.smoothedRttNs(), std::memory_order_relaxed);
+    m_lossRate.store(m_tracker.lossRate(), std::memory_order_relaxed);
+    emit linkQualityChanged(m_tracker.smoothedRttNs() / 1e6, m_tracker.lossRate());
+}
+
+void ControlLink::onUdpReadyRead()
+{
+    QUdpSocket *socket = qobject_cast<QUdpSocket *>(sender());
+    if (!socket)
+        return;
+
+    char buffer[MaxDatagramSize];
+    bool updated = false;
+    while (socket->hasPendingDatagrams()) {
+        qint64 size = socket->readDatagram(buffer, sizeof(buffer));
+        if (size <= 0)
+            continue;
+
+        if (size >= ControlProtocol::HeaderSize
+            && static_cast<quint8>(buffer[3]) == ControlProtocol::ScanMessage) {
+            receiveScan(buffer, size);
+            continue;
+        }
+
+        qint64 now = MonotonicClock::timestampNs();
+        quint32 sequence;
+        qint64 sentNs;
+        qint64 rtt = -1;
+        bool stopAck;
+        if (ControlProtocol::decodeAck(buffer, size, &sequence, &sentNs)) {
+            rtt = m_tracker.acknowledged(sequence, sentNs, now);
+            stopAck = m_protocolFormat == ControlProtocol::Binary && sequence == m_stopSequence;
+        } else if (size > 4 && std::memcmp(buffer, "ACK:", 4) == 0) {
+            rtt = m_tracker.acknowledged(buffer + 4, static_cast<int>(size - 4), now);
+            stopAck = size == 8 && std::memcmp(buffer + 4, "STOP", 4) == 0;
+        } else {
+            continue;
+        }
+
+        if (stopAck)
+            stopAcknowledged(rtt);
+
+        updated = true;
+        if (rtt >= 0)
+            emit roundTripTimeMeasured(rtt / 1e6);
+    }
+
+    if (updated) {
+        scheduleRetransmit();
+        publishLinkQuality();
+    }
+}
+
+void ControlLink::onTcpReadyRead()
+{
+    // The stream carries binary messages, self-delimiting, and text lines
+    // (WELCOME, ACK:...) which are skipped. Everything is parsed in place.
+    for (;;) {
+        qint64 read = m_tcpClient->read(m_tcpRead + m_tcpReadSize, TcpReadBufferSize - m_tcpReadSize);
+        if (read <= 0)
+            break;
+        m_tcpReadSize += static_cast<int>(read);
+
+        int offset = 0;
+        while (offset < m_tcpReadSize) {
+            const char *data = m_tcpRead + offset;
+            int available = m_tcpReadSize - offset;
+            int size = ControlProtocol::messageSize(data, available);
+            if (size > 0) {
+                if (size > TcpReadBufferSize) {
+                    // Can never be buffered whole; drop what there is and
+                    // resynchronize on the next message or line
+                    m_scansMalformed.fetch_add(1, std::memory_order_relaxed);
+                    offset = m_tcpReadSize;
+                    break;
+                }
+                if (size > available)
+                    break;
+                if (static_cast<quint8>(data[3]) == ControlProtocol::ScanMessage)
+                    receiveScan(data, size);
+                else
+                    receiveTcpAck(data, size);
+                offset += size;
+            } else if (size < 0) {
+                const char *end = static_cast<const char *>(std::memchr(data, '\n', available));
+                if (!end) {
+                    // An overlong line is dropped; otherwise wait for the rest
+                    if (offset == 0 && m_tcpReadSize == TcpReadBufferSize)
+                        offset = m_tcpReadSize;
+                    break;
+                }
+                receiveTcpAck(data, static_cast<int>(end - data));
+                offset += static_cast<int>(end - data) + 1;
+            } else {
+                break;
+            }
+        }
+
+        if (offset > 0) {
+            m_tcpReadSize -= offset;
+            std::memmove(m_tcpRead, m_tcpRead + offset, m_tcpReadSize);
+        }
+    }
+}
+
+void ControlLink::receiveTcpAck(const char *data, int size)
+{
+    // Commands over TCP aren't tracked, only a STOP needs to know it arrived
+    if (!m_stopUnacknowledged)
+        return;
+
+    qint64 now = MonotonicClock::timestampNs();
+    quint32 sequence;
+    qint64 sentNs;
+    qint64 rtt;
+    if (ControlProtocol::decodeAck(data, size, &sequence, &sentNs)) {
+        if (m_protocolFormat != ControlProtocol::Binary || sequence != m_stopSequence)
+            return;
+        rtt = m_tracker.acknowledged(sequence, sentNs, now);
+        if (rtt < 0)
+            rtt = now - sentNs;  // Went over TCP only
+    } else {
+        if (size > 0 && data[size - 1] == '\r')
+            --size;
+        if (size != 8 || std::memcmp(data, "ACK:STOP", 8) != 0)
+            return;
+        rtt = m_tracker.acknowledged(data + 4, 4, now);
+    }
+
+    stopAcknowledged(rtt);
+    // The UDP copy needs no more retransmissions
+    scheduleRetransmit();
+    publishLinkQuality();
+}
+
+void ControlLink::stopAcknowledged(qint64 rttNs)
+{
+    if (!m_stopUnacknowledged)
+        return;
+
+    m_stopUnacknowledged = false;
+    qCInfo(controlLink) << "Emergency stop acknowledged";
+    emit emergencyStopAcknowledged(rttNs >= 0 ? rttNs / 1e6 : -1.0);
+}
+
+void ControlLink::receiveScan(const char *data, qint64 size)
+{
+    RadarScan &scan = m_scans.writeSlot();
+    if (!ControlProtocol::decodeScan(data, size, &scan)) {
+        m_scansMalformed.fetch_add(1, std::memory_order_relaxed);
+        qCDebug(controlLink) << "Malformed scan message," << size << "bytes";
+        return;
+    }
+
+    scan.receivedNs = MonotonicClock::timestampNs();
+    m_scans.publish();
+    m_scansReceived.fetch_add(1, std::memory_order_relaxed);
+
+    // One notification until the GUI thread takes the scan; newer scans
+    // just replace it
+    if (!m_scanNotifyPending.exchange(true, std::memory_order_acq_rel))
+        emit scanReady();
+}
+
+void ControlLink::onRetransmitTimeout()
+{
+    quint64 failed = m_tracker.failed();
+    qint64 now = MonotonicClock::timestampNs();
+    while (CommandTracker::Command *command = m_tracker.nextRetransmission(now)) {
+        if (m_protocolFormat == ControlProtocol::Binary && command->size >= ControlProtocol::HeaderSize)
+            ControlProtocol::restamp(command->data);
+        sendUdpData(command->data, command->size);
+        qCDebug(controlLink) << "Retransmitting command, attempt" << command->attempts;
+    }
+
+    if (m_tracker.failed() != failed)
+        emit errorOccurred("Command not acknowledged by the server, giving up");
+
+    scheduleRetransmit();
+    publishLinkQuality();
+}
+
+void ControlLink::onTcpConnected()
+{
+    qCDebug(controlLink) << "Connected to TCP server at" << m_serverAddress << ":" << m_tcpPort;
+    m_reconnectTimer->stop();
+    m_reconnectAttempts = 0;
+    m_tcpReadSize = 0;
+
+    // Commands are small and latency-bound: no Nagle delay, low-delay TOS,
+    // and a small kernel send buffer so a backlog builds up in the queue,
+    // where superseded commands are dropped, rather than in the kernel
+    m_tcpClient->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    m_tcpClient->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    m_tcpClient->setSocketOption(QAbstractSocket::TypeOfServiceOption, 0x10); // IPTOS_LOWDELAY
+    m_tcpClient->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, TcpSendBufferBytes);
+
+    if (m_tcpDownSinceNs != 0) {
+        m_tcpReconnectNs.store(MonotonicClock::timestampNs() - m_tcpDownSinceNs, std::memory_order_relaxed);
+        m_tcpDownSinceNs = 0;
+    }
+
+    // Replay a stop, the mode and the input state; queued one-shot motion
+    // commands are stale by now
+    for (int i = m_tcpQueueCount - 1; i >= 0; --i) {
+        if (priority(m_tcpQueue[i].type) > StatePriority) {
+            removeTcpQueued(i, 1);
+            m_tcpQueueDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (m_tcpQueueCount > 0) {
+        qCDebug(controlLink) << "Replaying" << m_tcpQueueCount << "queued commands";
+        m_tcpReplayed.fetch_add(static_cast<quint64>(m_tcpQueueCount), std::memory_order_relaxed);
+        sendTcpQueue();
+    }
+
+    emit serverConnected();
+}
+
+void ControlLink::onTcpDisconnected()
+{
+    qCDebug(controlLink) << "Disconnected from TCP server";
+    tcpWentDown();
+    emit serverDisconnected();
+    scheduleReconnect();
+}
+
+void ControlLink::onTcpError(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error)
+    QString errorMsg = m_tcpClient->errorString();
+    qCWarning(controlLink) << "TCP error:" << errorMsg;
+    tcpWentDown();
+    emit errorOccurred(errorMsg);
+    scheduleReconnect();
+}
+
+void ControlLink::tcpWentDown()
+{
+    if (m_tcpDownSinceNs == 0)
+        m_tcpDownSinceNs = MonotonicClock::timestampNs();
+}
+
+void ControlLink::scheduleReconnect()
+{
+    if (!m_autoReconnect || !m_tcpEnabled || m_reconnectTimer->isActive())
+        return;
+
+    // Exponential backoff with jitter: a long outage isn't polled at a fixed
+    // rate, and clients that lost the same server don't retry in lockstep
+    int ceiling = qMin(ReconnectMaxMs, ReconnectInitialMs << qMin(m_reconnectAttempts, 5));
+    int delay = ceiling / 2 + static_cast<int>(QRandomGenerator::global()->bounded(ceiling / 2 + 1));
+    ++m_reconnectAttempts;
+    qCDebug(controlLink) << "Reconnecting in" << delay << "ms";
+    m_reconnectTimer->start(delay);
+}
+
+void ControlLink::reconnectToServer()
+{
+    if (m_tcpClient->state() == QTcpSocket::UnconnectedState) {
+        qCDebug(controlLink) << "Attempting to reconnect to server...";
+        m_tcpReconnects.fetch_add(1, std::memory_order_relaxed);
+        connectToServer();
+    }
+}
+
+void ControlLink::connectToServer()
+{
+    if (m_serverAddress.isEmpty()) {
+        qCDebug(controlLink) << "Cannot connect: no server address set";
+        return;
+    }
+
+    if (m_tcpClient->state() == QTcpSocket::ConnectedState) {
+        qCDebug(controlLink) << "Already connected to server";
+        return;
+    }
+
+    qCDebug(controlLink) << "Connecting to TCP server at" << m_serverAddress << ":" << m_tcpPort;
+    m_tcpClient->connectToHost(m_serverAddress, m_tcpPort);
+}
@@ -0,0 +1,148 @@
+#include "controlprotocol.h"
+#include "radarscan.h"
+#include "monotonicclock.h"
+#include <QLatin1String>
+#include <QString>
+#include <QtEndian>
+#include <cstring>
+
+int ControlProtocol::encodeButton(ButtonCode button)
+{
+    m_buffer[HeaderSize] = static_cast<char>(button);
+    return finish(ButtonMessage, 1);
+}
+
+int ControlProtocol::encodeTouch(qint32 x, qint32 y)
+{
+    qToBigEndian<qint32>(x, m_buffer + HeaderSize);
+    qToBigEndian<qint32>(y, m_buffer + HeaderSize + 4);
+    return finish(TouchMessage, 8);
+}
+
+int ControlProtocol::encodeMode(bool autoMode)
+{
+    m_buffer[HeaderSize] = autoMode ? 1 : 0;
+    return finish(ModeMessage, 1);
+}
+
+int ControlProtocol::encodeState(quint8 directions, qint16 axisX, qint16 axisY, bool edge)
+{
+    m_buffer[HeaderSize] = static_cast<char>(directions);
+    m_buffer[HeaderSize + 1] = edge ? 1 : 0;
+    qToBigEndian<qint16>(axisX, m_buffer + HeaderSize + 2);
+    qToBigEndian<qint16>(axisY, m_buffer + HeaderSize + 4);
+    return finish(StateMessage, 6);
+}
+
+int ControlProtocol::encodeStop()
+{
+    return finish(StopMessage, 0);
+}
+
+int ControlProtocol::finish(MessageType type, int payloadSize)
+{
+    ++m_sequence;
+    qToBigEndian<quint16>(Magic, m_buffer);
+    m_buffer[2] = static_cast<char>(Version);
+    m_buffer[3] = static_cast<char>(type);
+    qToBigEndian<quint32>(m_sequence, m_buffer + 4);
+    qToBigEndian<qint64>(MonotonicClock::timestampNs(), m_buffer + 8);
+    qToBigEndian<quint16>(static_cast<quint16>(payloadSize), m_buffer + 16);
+    qToBigEndian<quint16>(0, m_buffer + 18);
+    return HeaderSize + payloadSize;
+}
+
+void ControlProtocol::writeBatchHeader(char *header, quint16 count, int messagesSize)
+{
+    qToBigEndian<quint16>(Magic, header);
+    header[2] = static_cast<char>(Version);
+    header[3] = static_cast<char>(BatchMessage);
+    qToBigEndian<quint32>(0, header + 4);
+    qToBigEndian<qint64>(MonotonicClock::timestampNs(), header + 8);
+    qToBigEndian<quint16>(static_cast<quint16>(2 + messagesSize), header + 16);
+    qToBigEndian<quint16>(0, header + 18);
+    qToBigEndian<quint16>(count, header + HeaderSize);
+}
+
+void ControlProtocol::stamp(char *message, qint64 sentNs)
+{
+    qToBigEndian<qint64>(sentNs, message + 8);
+}
+
+void ControlProtocol::restamp(char *message)
+{
+    stamp(message, MonotonicClock::timestampNs());
+    quint16 flags = qFromBigEndian<quint16>(message + 18);
+    qToBigEndian<quint16>(flags | RetransmitFlag, message + 18);
+}
+
+bool ControlProtocol::decodeAck(const char *data, qint64 size, quint32 *sequence, qint64 *sentNs)
+{
+    if (size < HeaderSize
+        || qFromBigEndian<quint16>(data) != Magic
+        || static_cast<quint8>(data[2]) != Version
+        || static_cast<quint8>(data[3]) != AckMessage) {
+        return false;
+    }
+
+    *sequence = qFromBigEndian<quint32>(data + 4);
+    *sentNs = qFromBigEndian<qint64>(data + 8);
+    return true;
+}
+
+int ControlProtocol::messageSize(const char *data, qint64 size)
+{
+    // Reject as early as possible, so a stream reader can tell a message
+    // from a text line after a byte or two
+    static const char prefix[3] = { char(Magic >> 8), char(Magic & 0xFF), char(Version) };
+    for (int i = 0; i < 3 && i < size; ++i) {
+        if (data[i] != prefix[i])
+            return -1;
+    }
+    if (size < HeaderSize)
+        return 0;
+    return HeaderSize + qFromBigEndian<quint16>(data + 16);
+}
+
+bool ControlProtocol::decodeScan(const char *data, qint64 size, RadarScan *scan)
+{
+    if (messageSize(data, size) <= 0
+        || static_cast<quint8>(data[3]) != ScanMessage
+        || size < HeaderSize + 2) {
+        return false;
+    }
+
+    int count = qFromBigEndian<quint16>(data + HeaderSize);
+    if (count > RadarScan::MaxPoints || size < HeaderSize + 2 + count * 4)
+        return false;
+
+    const char *point = data + HeaderSize + 2;
+    for (int i = 0; i < count; ++i, point += 4) {
+        scan->points[i].distance = qFromBigEndian<quint16>(point) / 1000.0f;
+        scan->points[i].angle = qFromBigEndian<quint16>(point + 2) / 100.0f;
+    }
+    scan->count = count;
+    scan->sequence = qFromBigEndian<quint32>(data + 4);
+    return true;
+}
+
+ControlProtocol::ButtonCode ControlProtocol::buttonCode(const char *name)
+{
+    if (std::strcmp(name, "UP") == 0)
+        return ButtonUp;
+    if (std::strcmp(name, "DOWN") == 0)
+        return ButtonDown;
+    if (std::strcmp(name, "LEFT") == 0)
+        return ButtonLeft;
+    if (std::strcmp(name, "RIGHT") == 0)
+        return ButtonRight;
+    return UnknownButton;
+}
+
+ControlProtocol::Format ControlProtocol::formatFromName(const QString &name, bool *ok)
+{
+    bool known = name == QLatin1String("text") || name == QLatin1String("binary");
+    if (ok)
+        *ok = known;
+    return name == QLatin1String("binary") ? Binary : Text;
+}
@@ -0,0 +1,116 @@
+#include "displaymapping.h"
+#include "videokernel.h"
+#include <cmath>
+
+#ifdef OPENCV_ENABLED
+#include <opencv2/opencv.hpp>
+#endif
+
+// Only define M_PI if not already defined
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+QImage frameToQImage(const CaptureFrame &frame, const QSize &displaySize, bool rotate180, FramePool &pool)
+{
+    // Without a display size yet, convert at the source resolution
+    QSize size = displaySize;
+    if (size.isEmpty())
+        size = QSize(frame.width, frame.height);
+
+    // Crop the source to the display aspect ratio (same framing as
+    // Qt::KeepAspectRatioByExpanding), centred
+    QSize cropSize = size.scaled(QSize(frame.width, frame.height), Qt::KeepAspectRatio);
+    if (cropSize.isEmpty())
+        return QImage();
+
+    QImage image = pool.acquire(size, QImage::Format_RGB32);
+    if (image.isNull())
+        return image;
+
+    int cropX = (frame.width - cropSize.width()) / 2;
+    int cropY = (frame.height - cropSize.height()) / 2;
+    VideoKernel::Source src = {
+        frame.data + static_cast<size_t>(cropY) * frame.stride + cropX * frame.channels,
+        cropSize.width(),
+        cropSize.height(),
+        frame.stride,
+        frame.channels == 3 ? VideoKernel::Bgr24 : VideoKernel::Gray8
+    };
+
+#ifdef OPENCV_ENABLED
+    if (cropSize.width() > size.width() || cropSize.height() > size.height()) {
+        // Shrinking: average the source pixels down to display resolution
+        // instead of point sampling, so detail doesn't alias. The kernel
+        // below then only converts and rotates at 1:1. One scratch frame
+        // per thread, reused across calls.
+        thread_local cv::Mat scaledFrame;
+        cv::Mat source(cropSize.height(), cropSize.width(), frame.channels == 3 ? CV_8UC3 : CV_8UC1,
+                       const_cast<uchar*>(src.data), static_cast<size_t>(frame.stride));
+        cv::resize(source, scaledFrame, cv::Size(size.width(), size.height()), 0, 0, cv::INTER_AREA);
+        src.data = scaledFrame.ptr<uint8_t>(0);
+        src.width = scaledFrame.cols;
+        src.height = scaledFrame.rows;
+        src.stride = static_cast<int>(scaledFrame.step);
+    }
+#endif
+
+    VideoKernel::Target dst = { image.bits(), image.width(), image.height(), image.bytesPerLine() };
+    VideoKernel::convertScaleRotate(src, dst, rotate180);
+    return image;
+}
+
+QPointF normalizeCoordinates(const QPoint &position, const QRect &videoRect, const QSize &frameSize)
+{
+    // Calculate scaling to fit the frame in the video area while maintaining aspect ratio
+    double frameAspect = static_cast<double>(frameSize.width()) / frameSize.height();
+    double videoAspect = static_cast<double>(videoRect.width()) / videoRect.height();
+
+    QRect actualVideoRect;
+    if (frameAspect > videoAspect) {
+        // Frame is wider than the video area - fit to width
+        int scaledHeight = static_cast<int>(videoRect.width() / frameAspect);
+        int yOffset = (videoRect.height() - scaledHeight) / 2;
+        actualVideoRect = QRect(videoRect.x(), videoRect.y() + yOffset,
+                                videoRect.width(), scaledHeight);
+    } else {
+        // Frame is taller than the video area - fit to height
+        int scaledWidth = static_cast<int>(videoRect.height() * frameAspect);
+        int xOffset = (videoRect.width() - scaledWidth) / 2;
+        actualVideoRect = QRect(videoRect.x() + xOffset, videoRect.y(),
+                                scaledWidth, videoRect.height());
+    }
+
+    // Convert the position to coordinates within the actual video area
+    QPoint relativeCoord = position - actualVideoRect.topLeft();
+
+    // Normalize to 0.0-1.0 range
+    double normalizedX = static_cast<double>(relativeCoord.x()) / actualVideoRect.width();
+    double normalizedY = static_cast<double>(relativeCoord.y()) / actualVideoRect.height();
+
+    // Clamp to valid range
+    normalizedX = qBound(0.0, normalizedX, 1.0);
+    normalizedY = qBound(0.0, normalizedY, 1.0);
+
+    return QPointF(normalizedX, normalizedY);
+}
+
+QPointF radarToWidget(float distance, float angle, const QSizeF &viewSize, float maxDistance)
+{
+    // The radar is centered at the bottom center of the view
+    float centerX = viewSize.width() / 2.0f;
+    float centerY = viewSize.height() - 10;  // Slight offset from bottom
+
+    // Scale distance to fit within the view
+    float scaledDistance = (distance / maxDistance) * (viewSize.height() - 20);
+
+    // Convert angle from degrees to radians
+    // With rotation: 0° is right (east), 90° is up (north), 180° is left (west)
+    float radians = (180 - angle) * M_PI / 180.0f;
+
+    // Calculate x and y positions (Note: we invert Y because widget coordinates go down)
+    float x = centerX + scaledDistance * cos(radians);
+    float y = centerY - scaledDistance * sin(radians);
+
+    return QPointF(x, y);
+}
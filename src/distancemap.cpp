@@ -1,4 +1,6 @@
 #include "distancemap.h"
+#include "guiwatchdog.h"
+#include "displaymapping.h"
 #include <QRandomGenerator>
 #include <QDebug>
 #include <QtCore/qcoreevent.h>
@@ -29,7 +31,8 @@ DistanceMap::DistanceMap(QWidget *parent) : QWidget(parent)
 DistanceMap::~DistanceMap()
 {
     m_simulationTimer->stop();
-    killTimer(m_animationTimerId);
+    if (m_animationTimerId)
+        killTimer(m_animationTimerId);
 }
 
 void DistanceMap::setMapSize(int width, int height)
@@ -39,6 +42,13 @@ void DistanceMap::setMapSize(int width, int height)
     update();
 }
 
+void DistanceMap::setDisplayTransform(bool rotate180, qreal scale)
+{
+    m_rotated180 = rotate180;
+    m_scale = scale > 0 ? scale : 1.0;
+    update();
+}
+
 void DistanceMap::addRadarPoint(float distance, float angle, QColor color)
 {
     RadarPoint point;
@@ -58,6 +68,31 @@ void DistanceMap::clearPoints()
     update();
 }
 
+void DistanceMap::setScan(const RadarScan &scan)
+{
+    GUI_WATCHDOG_SCOPE("DistanceMap::setScan");
+
+    if (!m_live) {
+        // Real data from now on: no random points, no random movement
+        m_live = true;
+        m_simulationTimer->stop();
+        killTimer(m_animationTimerId);
+        m_animationTimerId = 0;
+        m_points.reserve(RadarScan::MaxPoints);
+    }
+
+    // Shrinking keeps the capacity, so steady state doesn't allocate
+    m_points.resize(scan.count);
+    for (int i = 0; i < scan.count; ++i) {
+        RadarPoint &point = m_points[i];
+        point.distance = qMin(scan.points[i].distance, m_maxDistance);
+        point.angle = qBound(0.0f, scan.points[i].angle, 180.0f);
+        point.velocity = 0.0f;
+        point.color = distanceToColor(point.distance);
+    }
+    update();
+}
+
 void DistanceMap::updatePointPositions()
 {
     for (int i = 0; i < m_points.size(); ++i) {
@@ -83,6 +118,8 @@ void DistanceMap::updatePointPositions()
 
 void DistanceMap::generateSimulatedData()
 {
+    GUI_WATCHDOG_SCOPE("DistanceMap::generateSimulatedData");
+
     // Clear existing points and generate new ones
     clearPoints();
     
@@ -116,23 +153,7 @@ void DistanceMap::generateSimulatedData()
 
 QPointF DistanceMap::radarToWidget(float distance, float angle)
 {
-    // Convert polar coordinates (distance, angle) to widget coordinates
-    // The radar is centered at the bottom center of the widget
-    float centerX = width() / 2.0f;
-    float centerY = height() - 10;  // Slight offset from bottom
-    
-    // Scale distance to fit within the widget
-    float scaledDistance = (distance / m_maxDistance) * (height() - 20);
-    
-    // Convert angle from degrees to radians
-    // With rotation: 0° is right (east), 90° is up (north), 180° is left (west)
-    float radians = (180 - angle) * M_PI / 180.0f;
-    
-    // Calculate x and y positions (Note: we invert Y because widget coordinates go down)
-    float x = centerX + scaledDistance * cos(radians);
-    float y = centerY - scaledDistance * sin(radians);
-    
-    return QPointF(x, y);
+    return ::radarToWidget(distance, angle, QSizeF(viewWidth(), viewHeight()), m_maxDistance);
 }
 
 QColor DistanceMap::distanceToColor(float distance)
@@ -153,32 +174,41 @@ QColor DistanceMap::distanceToColor(float distance)
 
 void DistanceMap::paintEvent(QPaintEvent *event)
 {
+    GUI_WATCHDOG_SCOPE("DistanceMap::paintEvent");
+
     Q_UNUSED(event);
     
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
+
+    // Apply the display orientation once; everything below draws in view coordinates
+    if (m_rotated180) {
+        painter.translate(width(), height());
+        painter.rotate(180);
+    }
+    painter.scale(m_scale, m_scale);
     
     // Set a semi-transparent black background
-    painter.fillRect(rect(), QColor(0, 0, 0, 180));
+    painter.fillRect(QRectF(0, 0, viewWidth(), viewHeight()), QColor(0, 0, 0, 180));
     
     // Draw border
     painter.setPen(QPen(QColor(255, 255, 255, 200), 2));
-    painter.drawRect(QRectF(0, 0, width() - 1, height() - 1));
+    painter.drawRect(QRectF(0, 0, viewWidth() - 1, viewHeight() - 1));
     
     // Add title text
     painter.setPen(Qt::white);
     painter.setFont(QFont("Arial", 10, QFont::Bold));
-    painter.drawText(QRectF(0, 0, width(), 20), 
+    painter.drawText(QRectF(0, 0, viewWidth(), 20), 
                     Qt::AlignCenter, "Distance Radar");
     
     // Set the center point of the radar
-    float centerX = width() / 2.0f;
-    float centerY = height() - 10;
+    float centerX = viewWidth() / 2.0f;
+    float centerY = viewHeight() - 10;
     
     // Draw the half circles at 2-meter intervals
     painter.setPen(QPen(QColor(100, 100, 100, 150), 1));
     for (float dist = 2.0f; dist <= m_maxDistance; dist += 2.0f) {
-        float radius = (dist / m_maxDistance) * (height() - 20);
+        float radius = (dist / m_maxDistance) * (viewHeight() - 20);
         
         // Draw half circle (180 degrees)
         painter.drawArc(QRectF(centerX - radius, centerY - radius, 
@@ -229,6 +259,8 @@ void DistanceMap::paintEvent(QPaintEvent *event)
 
 void DistanceMap::timerEvent(QTimerEvent *event)
 {
+    GUI_WATCHDOG_SCOPE("DistanceMap::timerEvent");
+
     if (event && event->timerId() == m_animationTimerId) {
         updatePointPositions();
     }
@@ -0,0 +1,220 @@
+#include "filereplaysource.h"
+#include "opencvcapturesource.h"
+#include <QDebug>
+#include <QThread>
+#include <QUrl>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const char RawMagic[8] = {'K', 'R', 'I', 'A', 'R', 'A', 'W', '1'};
+const qint64 RawHeaderBytes = 8 + 4 * 4;
+}
+
+FileReplaySource::FileReplaySource(const QString &path)
+    : m_path(path)
+    , m_rawDump(path.endsWith(".kraw", Qt::CaseInsensitive))
+{
+}
+
+FileReplaySource::~FileReplaySource()
+{
+    close();
+}
+
+std::unique_ptr<CaptureSource> FileReplaySource::create(const QString &url)
+{
+    if (!supportsUrl(url))
+        return nullptr;
+    return std::unique_ptr<CaptureSource>(new FileReplaySource(pathFromUrl(url)));
+}
+
+bool FileReplaySource::supportsUrl(const QString &url)
+{
+#ifdef OPENCV_ENABLED
+    Q_UNUSED(url);
+    return true;
+#else
+    // Without OpenCV only raw dumps can be decoded
+    return pathFromUrl(url).endsWith(".kraw", Qt::CaseInsensitive);
+#endif
+}
+
+QString FileReplaySource::pathFromUrl(const QString &url)
+{
+    return QUrl(url).toLocalFile();
+}
+
+bool FileReplaySource::open()
+{
+    m_loopStartUs = -1;
+    m_clock.start();
+
+    if (m_rawDump) {
+        m_file.setFileName(m_path);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Cannot open frame dump" << m_path << ":" << m_file.errorString();
+            return false;
+        }
+
+        char header[RawHeaderBytes];
+        if (m_file.read(header, RawHeaderBytes) != RawHeaderBytes
+            || std::memcmp(header, RawMagic, sizeof(RawMagic)) != 0) {
+            qWarning() << "Not a frame dump:" << m_path;
+            m_file.close();
+            return false;
+        }
+
+        const uchar *fields = reinterpret_cast<const uchar*>(header) + sizeof(RawMagic);
+        int width = static_cast<int>(qFromLittleEndian<quint32>(fields));
+        int height = static_cast<int>(qFromLittleEndian<quint32>(fields + 4));
+        m_channels = static_cast<int>(qFromLittleEndian<quint32>(fields + 8));
+        if (width <= 0 || height <= 0 || (m_channels != 1 && m_channels != 3)) {
+            qWarning() << "Unsupported frame dump format:" << width << "x" << height
+                       << "channels:" << m_channels;
+            m_file.close();
+            return false;
+        }
+
+        m_frameSize = QSize(width, height);
+        m_frameBytes = static_cast<qint64>(width) * height * m_channels;
+        m_pixels.resize(static_cast<size_t>(m_frameBytes));
+        m_pendingFrameOffset = -1;
+        qDebug() << "Replaying frame dump" << m_path << m_frameSize << "channels:" << m_channels;
+        return true;
+    }
+
+#ifdef OPENCV_ENABLED
+    if (!m_capture.open(m_path.toStdString())) {
+        qWarning() << "Cannot open video file" << m_path;
+        return false;
+    }
+    m_frameSize = QSize(static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                        static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    qDebug() << "Replaying video file" << m_path << m_frameSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileReplaySource::close()
+{
+    m_file.close();
+#ifdef OPENCV_ENABLED
+    m_capture.release();
+#endif
+}
+
+bool FileReplaySource::grab()
+{
+#ifdef OPENCV_ENABLED
+    if (!m_rawDump)
+        return grabVideo();
+#endif
+    return grabRaw();
+}
+
+bool FileReplaySource::retrieve(CaptureFrame &frame)
+{
+#ifdef OPENCV_ENABLED
+    if (!m_rawDump)
+        return retrieveVideo(frame);
+#endif
+    return retrieveRaw(frame);
+}
+
+QSize FileReplaySource::frameSize() const
+{
+    return m_frameSize;
+}
+
+void FileReplaySource::waitForTimestamp(qint64 timestampUs)
+{
+    // Timestamps going backwards (or a huge gap) restart the timing
+    if (m_loopStartUs < 0 || timestampUs < m_lastTimestampUs
+        || timestampUs - m_lastTimestampUs > 10 * 1000 * 1000) {
+        m_loopStartUs = timestampUs;
+        m_wallOffsetUs = m_clock.nsecsElapsed() / 1000;
+    }
+    m_lastTimestampUs = timestampUs;
+
+    qint64 dueUs = m_wallOffsetUs + (timestampUs - m_loopStartUs);
+    qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    if (dueUs > nowUs)
+        QThread::usleep(static_cast<unsigned long>(dueUs - nowUs));
+}
+
+void FileReplaySource::restartLoop()
+{
+    // Next frame is the first of a new loop, shown right away
+    m_loopStartUs = -1;
+}
+
+bool FileReplaySource::grabRaw()
+{
+    if (!m_file.isOpen())
+        return false;
+
+    uchar stamp[8];
+    if (m_file.read(reinterpret_cast<char*>(stamp), sizeof(stamp)) != sizeof(stamp)
+        || m_file.size() - m_file.pos() < m_frameBytes) {
+        // End of the recording (or a truncated last frame): loop
+        if (!m_file.seek(RawHeaderBytes)
+            || m_file.read(reinterpret_cast<char*>(stamp), sizeof(stamp)) != sizeof(stamp)
+            || m_file.size() - m_file.pos() < m_frameBytes) {
+            return false;
+        }
+        restartLoop();
+    }
+
+    // Only remember where the pixels are; retrieve() reads them if needed
+    m_pendingFrameOffset = m_file.pos();
+    if (!m_file.seek(m_pendingFrameOffset + m_frameBytes))
+        return false;
+
+    waitForTimestamp(qFromLittleEndian<qint64>(stamp));
+    return true;
+}
+
+bool FileReplaySource::retrieveRaw(CaptureFrame &frame)
+{
+    if (m_pendingFrameOffset < 0)
+        return false;
+
+    qint64 next = m_file.pos();
+    bool ok = m_file.seek(m_pendingFrameOffset)
+              && m_file.read(reinterpret_cast<char*>(m_pixels.data()), m_frameBytes) == m_frameBytes;
+    m_file.seek(next);
+    m_pendingFrameOffset = -1;
+    if (!ok)
+        return false;
+
+    frame.data = m_pixels.data();
+    frame.width = m_frameSize.width();
+    frame.height = m_frameSize.height();
+    frame.stride = m_frameSize.width() * m_channels;
+    frame.channels = m_channels;
+    return true;
+}
+
+#ifdef OPENCV_ENABLED
+bool FileReplaySource::grabVideo()
+{
+    if (!m_capture.grab()) {
+        // End of the file: loop
+        m_capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+        if (!m_capture.grab())
+            return false;
+        restartLoop();
+    }
+
+    waitForTimestamp(static_cast<qint64>(m_capture.get(cv::CAP_PROP_POS_MSEC) * 1000.0));
+    return true;
+}
+
+bool FileReplaySource::retrieveVideo(CaptureFrame &frame)
+{
+    return OpenCvCaptureSource::retrieveFrom(m_capture, m_frame, m_converted, frame);
+}
+#endif
@@ -0,0 +1,99 @@
+#include "framepool.h"
+#include <QMutexLocker>
+#include <QPixelFormat>
+
+struct FramePool::Buffer
+{
+    ~Buffer() { delete[] data; }
+
+    uchar *data = nullptr;
+    QSize size;
+    QImage::Format format = QImage::Format_Invalid;
+    int bytesPerLine = 0;
+    std::shared_ptr<Shared> owner; // Only set while the buffer is on loan
+};
+
+struct FramePool::Shared
+{
+    ~Shared() { qDeleteAll(idle); }
+
+    QMutex mutex;
+    QVector<Buffer*> idle;
+    int maxIdle = 0;
+};
+
+FramePool::FramePool(int maxIdleBuffers)
+    : m_shared(std::make_shared<Shared>())
+    , m_hits(0)
+    , m_misses(0)
+{
+    m_shared->maxIdle = maxIdleBuffers;
+    // Reserve up front so returning a buffer never reallocates the list
+    m_shared->idle.reserve(maxIdleBuffers);
+}
+
+FramePool::~FramePool()
+{
+    // Buffers still on loan keep the shared state alive until they come back
+    trim();
+}
+
+QImage FramePool::acquire(const QSize &size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid)
+        return QImage();
+
+    Buffer *buffer = nullptr;
+    {
+        QMutexLocker locker(&m_shared->mutex);
+        for (int i = 0; i < m_shared->idle.size(); ++i) {
+            Buffer *candidate = m_shared->idle[i];
+            if (candidate->size == size && candidate->format == format) {
+                m_shared->idle[i] = m_shared->idle.last();
+                m_shared->idle.removeLast();
+                buffer = candidate;
+                break;
+            }
+        }
+    }
+
+    if (buffer) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+
+        // Scanlines are kept 32-bit aligned as QImage expects
+        int bitsPerPixel = QImage::toPixelFormat(format).bitsPerPixel();
+        buffer = new Buffer;
+        buffer->size = size;
+        buffer->format = format;
+        buffer->bytesPerLine = ((size.width() * bitsPerPixel + 31) / 32) * 4;
+        buffer->data = new uchar[static_cast<size_t>(buffer->bytesPerLine) * size.height()];
+    }
+
+    buffer->owner = m_shared;
+    return QImage(buffer->data, size.width(), size.height(), buffer->bytesPerLine,
+                  format, &FramePool::releaseBuffer, buffer);
+}
+
+void FramePool::trim()
+{
+    QMutexLocker locker(&m_shared->mutex);
+    qDeleteAll(m_shared->idle);
+    m_shared->idle.clear();
+}
+
+void FramePool::releaseBuffer(void *info)
+{
+    // Called by QImage when the last reference to a pooled buffer goes away,
+    // possibly on a different thread than the one that acquired it
+    Buffer *buffer = static_cast<Buffer*>(info);
+    std::shared_ptr<Shared> owner = std::move(buffer->owner);
+
+    QMutexLocker locker(&owner->mutex);
+    if (owner->idle.size() < owner->maxIdle) {
+        owner->idle.append(buffer);
+    } else {
+        delete buffer;
+    }
+}
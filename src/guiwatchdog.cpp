@@ -0,0 +1,143 @@
+#include "guiwatchdog.h"
+#include "monotonicclock.h"
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(guiWatchdog, "kria.watchdog")
+
+std::atomic<qint64> GuiWatchdog::s_stallThresholdNs(50 * 1000000LL);
+std::atomic<const char*> GuiWatchdog::s_currentHandler(nullptr);
+std::atomic<GuiWatchdog::Handler*> GuiWatchdog::s_handlers(nullptr);
+std::atomic<quint64> GuiWatchdog::s_stalls(0);
+
+GuiWatchdog::Handler::Handler(const char *name) : m_name(name)
+{
+    // Lock-free push; handlers are function statics, so this runs once each
+    m_next = s_handlers.load(std::memory_order_relaxed);
+    while (!s_handlers.compare_exchange_weak(m_next, this, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+    }
+}
+
+GuiWatchdog::Scope::Scope(Handler &handler)
+    : m_handler(handler)
+    , m_outer(s_currentHandler.exchange(handler.name(), std::memory_order_relaxed))
+    , m_startNs(MonotonicClock::timestampNs())
+{
+}
+
+GuiWatchdog::Scope::~Scope()
+{
+    qint64 durationNs = MonotonicClock::timestampNs() - m_startNs;
+    m_handler.m_histogram.record(durationNs);
+    s_currentHandler.store(m_outer, std::memory_order_relaxed);
+
+    if (durationNs > s_stallThresholdNs.load(std::memory_order_relaxed)) {
+        s_stalls.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(guiWatchdog) << "GUI thread blocked for" << durationNs / 1000000 << "ms in"
+                               << m_handler.name();
+    }
+}
+
+GuiWatchdog::GuiWatchdog(QObject *parent)
+    : QObject(parent)
+    , m_lastBeatNs(0)
+    , m_running(false)
+{
+    m_heartbeat.setTimerType(Qt::PreciseTimer);
+    m_heartbeat.setInterval(HeartbeatMs);
+    connect(&m_heartbeat, &QTimer::timeout, this, &GuiWatchdog::heartbeat);
+}
+
+GuiWatchdog::~GuiWatchdog()
+{
+    stop();
+}
+
+void GuiWatchdog::start()
+{
+    if (m_running.exchange(true))
+        return;
+
+    qint64 now = MonotonicClock::timestampNs();
+    m_lastBeatNs.store(now, std::memory_order_relaxed);
+    m_expectedBeatNs = now + HeartbeatMs * 1000000LL;
+    m_heartbeat.start();
+
+    m_monitor = QThread::create([this]() { monitor(); });
+    m_monitor->start(QThread::LowPriority);
+
+    qCInfo(guiWatchdog) << "GUI watchdog started, stall threshold" << stallThreshold() << "ms";
+}
+
+void GuiWatchdog::stop()
+{
+    if (!m_running.exchange(false))
+        return;
+
+    m_heartbeat.stop();
+    m_monitor->wait();
+    delete m_monitor;
+    m_monitor = nullptr;
+}
+
+void GuiWatchdog::setStallThreshold(int milliseconds)
+{
+    s_stallThresholdNs.store(qMax(1, milliseconds) * 1000000LL, std::memory_order_relaxed);
+}
+
+int GuiWatchdog::stallThreshold()
+{
+    return static_cast<int>(s_stallThresholdNs.load(std::memory_order_relaxed) / 1000000);
+}
+
+const GuiWatchdog::Handler *GuiWatchdog::handlers()
+{
+    return s_handlers.load(std::memory_order_acquire);
+}
+
+void GuiWatchdog::heartbeat()
+{
+    // How much later than scheduled the event loop got round to the timer
+    qint64 now = MonotonicClock::timestampNs();
+    m_lag.record(now - m_expectedBeatNs);
+    m_expectedBeatNs = now + HeartbeatMs * 1000000LL;
+    m_lastBeatNs.store(now, std::memory_order_relaxed);
+}
+
+void GuiWatchdog::monitor()
+{
+    // Check a few times per threshold; report each stall once while it lasts
+    qint64 reportedBeat = 0;
+    while (m_running.load(std::memory_order_relaxed)) {
+        qint64 thresholdNs = s_stallThresholdNs.load(std::memory_order_relaxed);
+        QThread::msleep(static_cast<unsigned long>(qMax<qint64>(1, thresholdNs / 4000000)));
+
+        qint64 lastBeat = m_lastBeatNs.load(std::memory_order_relaxed);
+        qint64 silentNs = MonotonicClock::timestampNs() - lastBeat;
+        if (silentNs > thresholdNs + HeartbeatMs * 1000000LL && lastBeat != reportedBeat) {
+            reportedBeat = lastBeat;
+            const char *handler = s_currentHandler.load(std::memory_order_relaxed);
+            qCWarning(guiWatchdog) << "GUI event loop stalled for" << silentNs / 1000000 << "ms, in"
+                                   << (handler ? handler : "an uninstrumented handler");
+        }
+    }
+}
+
+QString GuiWatchdog::report() const
+{
+    auto line = [](const QString &name, const LatencyHistogram &histogram) {
+        LatencyHistogram::Summary s = histogram.summary();
+        return QString("%1 count=%2 p50=%3 p99=%4 p999=%5 max=%6 ms\n")
+            .arg(name, -40)
+            .arg(s.count)
+            .arg(QString::number(s.p50 / 1e6, 'f', 3), QString::number(s.p99 / 1e6, 'f', 3),
+                 QString::number(s.p999 / 1e6, 'f', 3), QString::number(s.max / 1e6, 'f', 3));
+    };
+
+    QString text = line("event loop lag", m_lag);
+    for (const Handler *handler = handlers(); handler; handler = handler->next())
+        text += line(handler->name(), handler->histogram());
+    text += QString("stalls over %1 ms: %2\n").arg(stallThreshold()).arg(stallCount());
+    return text;
+}
@@ -0,0 +1,131 @@
+#include "inputsampler.h"
+#include <QString>
+#include <QtMath>
+
+InputSampler::InputSampler(QObject *parent)
+    : QObject(parent)
+    , m_deadband(0.15)
+{
+    for (quint8 &held : m_held)
+        held = 0;
+    m_rawAxis[AxisX] = 0.0;
+    m_rawAxis[AxisY] = 0.0;
+
+    m_tickTimer.setTimerType(Qt::PreciseTimer);
+    m_tickTimer.setInterval(20); // 50 Hz
+    connect(&m_tickTimer, &QTimer::timeout, this, &InputSampler::onTick);
+}
+
+void InputSampler::setTickRate(int hz)
+{
+    m_tickTimer.setInterval(1000 / qBound(1, hz, 1000));
+}
+
+int InputSampler::tickRate() const
+{
+    return 1000 / m_tickTimer.interval();
+}
+
+void InputSampler::setDeadband(double deadband)
+{
+    m_deadband = qBound(0.0, deadband, 0.95);
+    update();
+}
+
+void InputSampler::setDirection(Source source, Direction direction, bool held)
+{
+    if (held)
+        m_held[source] |= direction;
+    else
+        m_held[source] &= ~direction;
+    update();
+}
+
+void InputSampler::setAxis(Axis axis, double value)
+{
+    m_rawAxis[axis] = qBound(-1.0, value, 1.0);
+    update();
+}
+
+void InputSampler::releaseAll()
+{
+    for (quint8 &held : m_held)
+        held = 0;
+    m_rawAxis[AxisX] = 0.0;
+    m_rawAxis[AxisY] = 0.0;
+    update();
+}
+
+void InputSampler::update()
+{
+    InputState state;
+    for (quint8 held : m_held)
+        state.directions |= held;
+    state.axisX = applyDeadband(m_rawAxis[AxisX]);
+    state.axisY = applyDeadband(m_rawAxis[AxisY]);
+
+    if (state == m_state)
+        return;
+
+    // Stick motion within the active range waits for the next tick; anything
+    // that starts or stops movement goes out now
+    bool edge = state.directions != m_state.directions
+             || (state.axisX == 0) != (m_state.axisX == 0)
+             || (state.axisY == 0) != (m_state.axisY == 0);
+    m_state = state;
+
+    if (!edge)
+        return;
+
+    emit sampled(m_state, true);
+
+    // Restart the tick phase at the edge; stop ticking once idle
+    if (m_state.isIdle())
+        m_tickTimer.stop();
+    else
+        m_tickTimer.start();
+}
+
+void InputSampler::onTick()
+{
+    emit sampled(m_state, false);
+}
+
+qint16 InputSampler::applyDeadband(double value) const
+{
+    double magnitude = qAbs(value);
+    if (magnitude <= m_deadband)
+        return 0;
+
+    double scaled = (magnitude - m_deadband) / (1.0 - m_deadband);
+    qint16 result = static_cast<qint16>(qRound(scaled * 32767));
+    return value < 0 ? static_cast<qint16>(-result) : result;
+}
+
+InputSampler::Direction InputSampler::directionFromName(const QString &name)
+{
+    if (name == QLatin1String("UP"))
+        return Up;
+    if (name == QLatin1String("DOWN"))
+        return Down;
+    if (name == QLatin1String("LEFT"))
+        return Left;
+    if (name == QLatin1String("RIGHT"))
+        return Right;
+    return static_cast<Direction>(0);
+}
+
+const char *InputSampler::directionName(Direction direction)
+{
+    switch (direction) {
+    case Up:
+        return "UP";
+    case Down:
+        return "DOWN";
+    case Left:
+        return "LEFT";
+    case Right:
+        return "RIGHT";
+    }
+    return "";
+}
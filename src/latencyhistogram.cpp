@@ -0,0 +1,95 @@
+#include "latencyhistogram.h"
+#include <QtAlgorithms>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 nanoseconds)
+{
+    if (nanoseconds < 0)
+        nanoseconds = 0;
+
+    m_buckets[bucketIndex(static_cast<quint64>(nanoseconds))].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(static_cast<quint64>(nanoseconds), std::memory_order_relaxed);
+
+    qint64 max = m_max.load(std::memory_order_relaxed);
+    while (nanoseconds > max
+           && !m_max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    // Copy the counts first so all percentiles come from the same data
+    quint64 counts[BucketCount];
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = total;
+    if (total == 0)
+        return summary;
+
+    summary.max = m_max.load(std::memory_order_relaxed);
+    summary.sum = static_cast<qint64>(m_sum.load(std::memory_order_relaxed));
+    summary.mean = summary.sum / static_cast<qint64>(total);
+
+    // Walk the buckets once, filling in the percentiles in ascending order
+    const struct { double quantile; qint64 *value; } targets[] = {
+        { 0.50, &summary.p50 }, { 0.90, &summary.p90 }, { 0.99, &summary.p99 }, { 0.999, &summary.p999 }
+    };
+    const int targetCount = sizeof(targets) / sizeof(targets[0]);
+
+    int target = 0;
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount && target < targetCount; ++i) {
+        seen += counts[i];
+        while (target < targetCount && seen >= static_cast<quint64>(targets[target].quantile * total + 0.5)) {
+            // Report the bucket's upper bound, but never more than the true max
+            *targets[target].value = qMin(bucketUpperBound(i), summary.max);
+            ++target;
+        }
+    }
+    return summary;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; ++i)
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+    // Values below SubBuckets get one bucket each; above that, the top
+    // SubBucketBits bits after the leading one select the sub-bucket
+    if (value < static_cast<quint64>(SubBuckets))
+        return static_cast<int>(value);
+
+    int exponent = 63 - static_cast<int>(qCountLeadingZeroBits(value));
+    if (exponent > MaxExponent)
+        return BucketCount - 1;
+
+    int subBucket = static_cast<int>((value >> (exponent - SubBucketBits)) & (SubBuckets - 1));
+    return (exponent - SubBucketBits + 1) * SubBuckets + subBucket;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SubBuckets)
+        return index;
+
+    int exponent = index / SubBuckets + SubBucketBits - 1;
+    int subBucket = index % SubBuckets;
+    qint64 width = qint64(1) << (exponent - SubBucketBits);
+    return (SubBuckets + subBucket) * width + width - 1;
+}
@@ -0,0 +1,99 @@
+#include "latencyprobe.h"
+#include <QDateTime>
+#include <QDebug>
+
+namespace {
+// Stamp layout, see tests/latency_source.py
+const int Grid = 8;
+const quint64 Sync = 0xB2;
+const qint64 TimestampMask = (qint64(1) << 40) - 1;
+
+quint64 reverseBits(quint64 value)
+{
+    quint64 result = 0;
+    for (int i = 0; i < 64; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+}
+
+void LatencyProbe::framePainted(const QImage &frame, const QSize &streamSize)
+{
+    Stamp stamp;
+    if (!decode(frame, streamSize, &stamp)) {
+        ++m_undecoded;
+        return;
+    }
+
+    // Both ends use the wall clock, so this only works on loopback or with
+    // synchronized clocks; compare modulo 2^40 ms
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch() & TimestampMask;
+    qint64 ageMs = (nowMs - stamp.timestampMs) & TimestampMask;
+    if (ageMs > TimestampMask / 2)
+        ageMs = 0; // Sender clock ahead of ours
+    m_histogram.record(ageMs * 1000000);
+    ++m_decoded;
+
+    if (m_haveCounter) {
+        quint16 gap = static_cast<quint16>(stamp.counter - m_lastCounter);
+        if (gap > 1)
+            m_missed += gap - 1;
+    }
+    m_haveCounter = true;
+    m_lastCounter = stamp.counter;
+
+    if (m_decoded % 300 == 0)
+        qInfo().noquote() << "Glass-to-glass latency:" << report();
+}
+
+QString LatencyProbe::report() const
+{
+    LatencyHistogram::Summary s = m_histogram.summary();
+    return QString("frames=%1 undecoded=%2 missed=%3 mean=%4 p50=%5 p99=%6 p999=%7 max=%8 ms")
+        .arg(m_decoded)
+        .arg(m_undecoded)
+        .arg(m_missed)
+        .arg(s.mean / 1000000)
+        .arg(s.p50 / 1000000)
+        .arg(s.p99 / 1000000)
+        .arg(s.p999 / 1000000)
+        .arg(s.max / 1000000);
+}
+
+bool LatencyProbe::decode(const QImage &frame, const QSize &streamSize, Stamp *stamp)
+{
+    if (frame.isNull() || streamSize.isEmpty())
+        return false;
+
+    // The frame is the stream scaled to fill the display and centre-cropped;
+    // the stamp grid sits in the centre, so only the scale matters
+    qreal scale = qMax(static_cast<qreal>(frame.width()) / streamSize.width(),
+                       static_cast<qreal>(frame.height()) / streamSize.height());
+    qreal cell = (qMin(streamSize.width(), streamSize.height()) / 16) * scale;
+    if (cell < 2)
+        return false;
+    qreal x0 = (frame.width() - Grid * cell) / 2;
+    qreal y0 = (frame.height() - Grid * cell) / 2;
+
+    quint64 bits = 0;
+    for (int i = 0; i < Grid * Grid; ++i) {
+        int x = static_cast<int>(x0 + (i % Grid + 0.5) * cell);
+        int y = static_cast<int>(y0 + (i / Grid + 0.5) * cell);
+        if (!frame.valid(x, y))
+            return false;
+        bits = (bits << 1) | (qGray(frame.pixel(x, y)) >= 128 ? 1 : 0);
+    }
+
+    // A display rotated by 180 degrees reverses the cell order
+    if ((bits >> 56) != Sync) {
+        bits = reverseBits(bits);
+        if ((bits >> 56) != Sync)
+            return false;
+    }
+
+    stamp->timestampMs = static_cast<qint64>((bits >> 16) & static_cast<quint64>(TimestampMask));
+    stamp->counter = static_cast<quint16>(bits & 0xFFFF);
+    return true;
+}
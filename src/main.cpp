@@ -1,37 +1,90 @@
 #include "mainwindow.h"
+#include "asynclogger.h"
 #include <QApplication>
-#include <QGraphicsView>
-#include <QGraphicsScene>
-#include <QGraphicsProxyWidget>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
 
-    // Create your main window (but don't show it directly)
-    MainWindow w;
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("url", "Stream URL, e.g. synthetic://1920x1080@60 or file:///tmp/run.kraw");
+    QCommandLineOption latencyProbeOption("latency-probe",
+                                          "Measure glass-to-glass latency against tests/latency_source.py");
+    parser.addOption(latencyProbeOption);
+    QCommandLineOption stallThresholdOption("stall-threshold",
+                                            "Log GUI thread handlers and stalls longer than this (default 50).",
+                                            "ms", "50");
+    parser.addOption(stallThresholdOption);
+    QCommandLineOption metricsPortOption("metrics-port",
+                                         "Serve Prometheus metrics on 127.0.0.1:<port>/metrics.",
+                                         "port", "0");
+    parser.addOption(metricsPortOption);
+    QCommandLineOption logLevelOption("log-level",
+                                      "Lowest message level logged: debug, info, warning or critical (default info).",
+                                      "level", "info");
+    parser.addOption(logLevelOption);
+    QCommandLineOption controlProtocolOption("control-protocol",
+                                             "Controller command format: text or binary (default text).",
+                                             "format", "text");
+    parser.addOption(controlProtocolOption);
+    QCommandLineOption controlRealtimeOption("control-realtime",
+                                             "Run the controller's network thread with real-time priority (needs CAP_SYS_NICE).");
+    parser.addOption(controlRealtimeOption);
+    QCommandLineOption inputRateOption("input-rate",
+                                       "Send held directions this many times per second, 0 for one command per key press (default 50).",
+                                       "hz", "50");
+    parser.addOption(inputRateOption);
+    QCommandLineOption controlBatchOption("control-batch",
+                                          "Let a command wait this long to share a datagram with others, or 'off' (default 0: only commands pending together).",
+                                          "ms", "0");
+    parser.addOption(controlBatchOption);
+    QCommandLineOption telemetryPortOption("telemetry-port",
+                                           "Also receive telemetry scans on this local UDP port (default 0: only replies to the command socket and TCP).",
+                                           "port", "0");
+    parser.addOption(telemetryPortOption);
+    parser.process(a);
 
-    // Create graphics view and scene for rotation
-    QGraphicsView *view = new QGraphicsView();
-    QGraphicsScene *scene = new QGraphicsScene();
-    view->setScene(scene);
+    // Log from a background thread so formatting and stderr writes never
+    // block the GUI or capture threads
+    AsyncLogger::install();
+    if (!AsyncLogger::setMinimumLevel(parser.value(logLevelOption)))
+        qWarning() << "Unknown log level" << parser.value(logLevelOption);
 
-    // Add the main window to the scene and rotate it 180 degrees
-    QGraphicsProxyWidget *proxy = scene->addWidget(&w);
-    proxy->setRotation(180);
+    GuiWatchdog::setStallThreshold(parser.value(stallThresholdOption).toInt());
 
-    // Remove scroll bars for clean fullscreen
-    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    view->setFrameStyle(0);
+    int result;
+    {
+        // The display is mounted upside down: MainWindow rotates the video and
+        // the overlay itself, so it is shown directly without a QGraphicsView
+        MainWindow w;
+        w.setDisplayOrientation(180, 1.6);
 
-    // SCALE TO FILL THE ENTIRE SCREEN
-    view->scale(1.9, 1.6);  // Start with 1:1 scale
-    view->setAlignment(Qt::AlignCenter);
+        if (!parser.positionalArguments().isEmpty())
+            w.setStreamUrl(parser.positionalArguments().first());
+        w.setLatencyProbeEnabled(parser.isSet(latencyProbeOption));
+        w.setMetricsPort(static_cast<quint16>(parser.value(metricsPortOption).toUInt()));
 
-    // Show the rotated view
-    view->showFullScreen();
+        bool knownFormat = false;
+        ControlProtocol::Format format = ControlProtocol::formatFromName(parser.value(controlProtocolOption), &knownFormat);
+        if (!knownFormat)
+            qWarning() << "Unknown control protocol" << parser.value(controlProtocolOption) << "- using text";
+        w.setControlProtocol(format);
+        if (parser.isSet(controlRealtimeOption))
+            w.setControlRealtimePriority(true);
+        w.setInputTickRate(parser.value(inputRateOption).toInt());
+        QString batch = parser.value(controlBatchOption);
+        w.setControlBatchLatency(batch == QLatin1String("off") ? -1 : batch.toInt());
+        w.setTelemetryPort(static_cast<quint16>(parser.value(telemetryPortOption).toUInt()));
 
+        // Show fullscreen
+        w.showFullScreen();
 
-    return a.exec();
+        result = a.exec();
+    }
+
+    // Everything that logs from other threads has been torn down with the window
+    AsyncLogger::shutdown();
+    return result;
 }
@@ -1,5 +1,8 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "guiwatchdog.h"
+#include "displaymapping.h"
+#include "monotonicclock.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
@@ -8,54 +11,15 @@
 #include <QPainter>
 #include <QDebug>
 #include <QLoggingCategory>
-#include <QDateTime>
 #include <QMouseEvent>
 
 Q_LOGGING_CATEGORY(mainWindow, "kria.mainwindow")
 
-// Custom debug handler for better logging
-void customDebugHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
-{
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    QString typeStr;
-
-    switch (type) {
-    case QtDebugMsg:
-        typeStr = "DEBUG";
-        break;
-    case QtInfoMsg:
-        typeStr = "INFO";
-        break;
-    case QtWarningMsg:
-        typeStr = "WARNING";
-        break;
-    case QtCriticalMsg:
-        typeStr = "CRITICAL";
-        break;
-    case QtFatalMsg:
-        typeStr = "FATAL";
-        break;
-    }
-
-    QString formattedMessage = QString("%1 [%2] %3: %4")
-                                   .arg(timestamp)
-                                   .arg(typeStr)
-                                   .arg(context.category)
-                                   .arg(msg);
-
-    // Output to stderr for all message types
-    fprintf(stderr, "%s\n", formattedMessage.toLocal8Bit().constData());
-    fflush(stderr);
-}
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_rtspStreamer(new RTSPStreamer(this))
 {
-    // Install custom debug handler
-    qInstallMessageHandler(customDebugHandler);
-
     qCInfo(mainWindow) << "Starting Kria application";
 
     // Initialize RTSP URL from address and port
@@ -66,12 +30,20 @@ MainWindow::MainWindow(QWidget *parent)
 
 
     // Connect signals and slots
-    connect(m_rtspStreamer, &RTSPStreamer::newFrameAvailable, this, &MainWindow::updateFrame);
+    connect(m_rtspStreamer, &RTSPStreamer::frameReady, this, &MainWindow::updateFrame, Qt::QueuedConnection);
     connect(m_rtspStreamer, &RTSPStreamer::connectionFailed, this, &MainWindow::handleConnectionError);
 
+    // Tell the streamer when the GUI is ready for the next frame
+    connect(m_videoWidget, &VideoWidget::framePresented, m_rtspStreamer, &RTSPStreamer::acknowledgeFrame);
+    connect(m_videoWidget, &VideoWidget::framePresented, this, &MainWindow::handleFramePresented);
+
     // Set up native controller for remote control
     setupNativeController();
 
+    // Watch the GUI thread for slow handlers and event loop stalls
+    m_watchdog = new GuiWatchdog(this);
+    m_watchdog->start();
+
     // Set window to fullscreen immediately
     setWindowTitle("RTSP Stream Viewer");
     //showFullScreen();
@@ -90,6 +62,14 @@ MainWindow::~MainWindow()
         m_rtspStreamer->wait();
     }
 
+    // Dump where frames spent their time during this run
+    qCInfo(mainWindow).noquote() << "Pipeline latency:\n" + m_rtspStreamer->latency().report();
+    if (m_latencyProbe)
+        qCInfo(mainWindow).noquote() << "Glass-to-glass latency:" << m_latencyProbe->report();
+
+    m_watchdog->stop();
+    qCInfo(mainWindow).noquote() << "GUI thread:\n" + m_watchdog->report();
+
     // Stop native controller if it exists
     if (m_nativeController) {
         m_nativeController->stopController();
@@ -106,19 +86,17 @@ void MainWindow::setupUI()
     mainLayout->setContentsMargins(0, 0, 0, 0); // Remove margins for fullscreen
 
     // Create video display section - full window size
-    m_videoLabel = new QLabel(this);
-    m_videoLabel->setAlignment(Qt::AlignCenter);
-    m_videoLabel->setStyleSheet("QLabel { background-color: black; }");
+    m_videoWidget = new VideoWidget(this);
 
-    // Add video label to main layout
-    mainLayout->addWidget(m_videoLabel);
+    // Add video surface to main layout
+    mainLayout->addWidget(m_videoWidget);
 
     // Set the central widget
     setCentralWidget(centralWidget);
 
     // Create the distance map widget (top right corner)
     m_distanceMap = new DistanceMap(this);
-    m_distanceMap->setFixedSize(200, 200);
+    m_distanceMap->setFixedSize(scaledSize(200), scaledSize(200));
     m_distanceMap->setMapSize(15, 15);
     m_distanceMap->raise(); // Ensure it's on top
 
@@ -126,9 +104,15 @@ void MainWindow::setupUI()
     m_distanceMap->setAttribute(Qt::WA_OpaquePaintEvent, true);
     m_distanceMap->setAttribute(Qt::WA_NoSystemBackground, true);
 
+    // Performance overlay (top left), toggled with H
+    m_hud = new PerformanceHud(this);
+    m_hud->setStreamer(m_rtspStreamer);
+    m_hud->hide();
+    connect(this, &MainWindow::framePainted, m_hud, &PerformanceHud::framePainted);
+
     // Create the AUTO/MANUAL toggle button
-    m_toggleButton = new QPushButton(this);
-    m_toggleButton->setMinimumSize(150, 80);  // Make the button large
+    m_toggleButton = new OverlayButton(QString(), this);
+    m_toggleButton->setMinimumSize(scaledSize(150), scaledSize(80));  // Make the button large
     m_toggleButton->setFocusPolicy(Qt::NoFocus); // Don't steal keyboard focus
     updateButtonStyle(); // Set initial style
 
@@ -144,6 +128,9 @@ void MainWindow::setupUI()
     // Initially hide arrow buttons (since we start in AUTO mode)
     updateArrowButtonsVisibility();
 
+    // Orient the overlay to match the display
+    applyDisplayOrientation();
+
     // Focus policy for key events
     setFocusPolicy(Qt::StrongFocus);
 
@@ -151,56 +138,119 @@ void MainWindow::setupUI()
     setCursor(Qt::ArrowCursor);
 }
 
-void MainWindow::updateFrame(const QImage &frame)
+void MainWindow::updateFrame()
 {
-    if (!frame.isNull()) {
-        // Use faster scaling for better performance
-        QImage scaledImage = frame.scaled(m_videoLabel->size(),
-                                          Qt::KeepAspectRatioByExpanding,
-                                          Qt::FastTransformation);
+    GUI_WATCHDOG_SCOPE("MainWindow::updateFrame");
+
+    // Always show the newest frame; stale ones were already dropped by the streamer.
+    // The video widget keeps a reference and paints it in its own paintEvent.
+    VideoFrame frame = m_rtspStreamer->currentFrame();
+    frame.timestamps.received = MonotonicClock::timestampNs();
+    if (!frame.image.isNull() && m_videoWidget->setFrame(frame.image)) {
+        frame.timestamps.presented = MonotonicClock::timestampNs();
+        m_shownSequence = frame.sequence;
+        m_shownTimestamps = frame.timestamps;
+    }
+}
 
-        // Create a pixmap the size of the label
-        QPixmap pixmap(m_videoLabel->size());
-        pixmap.fill(Qt::black);
+void MainWindow::handleFramePresented(bool painted)
+{
+    // Only the most recently set frame can be painted; older ones are
+    // reported as skipped before the new one is accepted
+    if (!painted)
+        return;
+
+    m_shownTimestamps.painted = MonotonicClock::timestampNs();
+    m_rtspStreamer->latency().recordPainted(m_shownTimestamps);
+    if (m_latencyProbe)
+        m_latencyProbe->framePainted(m_videoWidget->currentFrame(), m_rtspStreamer->getStreamSize());
+    emit framePainted(m_shownSequence, m_shownTimestamps);
+}
+
+void MainWindow::setLatencyProbeEnabled(bool enabled)
+{
+    if (enabled && !m_latencyProbe) {
+        m_latencyProbe.reset(new LatencyProbe);
+        qCInfo(mainWindow) << "Glass-to-glass latency probe enabled";
+    } else if (!enabled) {
+        m_latencyProbe.reset();
+    }
+
+    if (m_metricsServer)
+        m_metricsServer->setLatencyProbe(m_latencyProbe.get());
+}
 
-        // Create a painter to draw the scaled image centered on the pixmap
-        QPainter painter(&pixmap);
-        painter.setRenderHint(QPainter::Antialiasing, false); // Disable antialiasing for speed
-        int x = (pixmap.width() - scaledImage.width()) / 2;
-        int y = (pixmap.height() - scaledImage.height()) / 2;
-        painter.drawImage(x, y, scaledImage);
-        painter.end();
+void MainWindow::setMetricsPort(quint16 port)
+{
+    delete m_metricsServer;
+    m_metricsServer = nullptr;
+    if (port == 0)
+        return;
 
-        m_videoLabel->setPixmap(pixmap);
+    m_metricsServer = new MetricsServer(this);
+    m_metricsServer->setStreamer(m_rtspStreamer);
+    m_metricsServer->setController(m_nativeController);
+    m_metricsServer->setWatchdog(m_watchdog);
+    m_metricsServer->setLatencyProbe(m_latencyProbe.get());
+    if (!m_metricsServer->listen(port)) {
+        delete m_metricsServer;
+        m_metricsServer = nullptr;
     }
 }
 
+void MainWindow::setControlProtocol(ControlProtocol::Format format)
+{
+    if (m_nativeController)
+        m_nativeController->setProtocolFormat(format);
+}
+
+void MainWindow::setControlRealtimePriority(bool enabled)
+{
+    if (m_nativeController)
+        m_nativeController->setRealtimePriority(enabled);
+}
+
+void MainWindow::setInputTickRate(int hz)
+{
+    if (m_nativeController)
+        m_nativeController->setInputTickRate(hz);
+}
+
+void MainWindow::setControlBatchLatency(int ms)
+{
+    if (m_nativeController)
+        m_nativeController->setBatchLatency(ms);
+}
+
+void MainWindow::setTelemetryPort(quint16 port)
+{
+    if (m_nativeController)
+        m_nativeController->setTelemetryPort(port);
+}
+
+StreamStats MainWindow::streamStats() const
+{
+    return m_rtspStreamer->stats();
+}
+
+GuiWatchdog *MainWindow::watchdog() const
+{
+    return m_watchdog;
+}
+
+PipelineLatency &MainWindow::pipelineLatency()
+{
+    return m_rtspStreamer->latency();
+}
+
 void MainWindow::handleConnectionError()
 {
     qCWarning(mainWindow) << "RTSP connection failed for URL:" << m_rtspUrl;
 
-    // Display error message directly on video label instead of showing a message box
-    QPixmap errorPixmap(m_videoLabel->size());
-    errorPixmap.fill(Qt::black);
-
-    QPainter painter(&errorPixmap);
-    painter.setPen(Qt::white);
-    painter.setFont(QFont("Arial", 16));
-
-#ifdef OPENCV_ENABLED
-    painter.drawText(errorPixmap.rect(), Qt::AlignCenter,
-                     "Connection Error: Failed to connect to RTSP stream.\n"
-                     "URL: " + m_rtspUrl + "\n"
-                                       "Press R to reconnect or Q to quit.");
-#else
-    painter.drawText(errorPixmap.rect(), Qt::AlignCenter,
-                     "OpenCV Not Available\n"
-                     "RTSP streaming is disabled.\n"
-                     "Press Q to quit.");
-#endif
-    painter.end();
-
-    m_videoLabel->setPixmap(errorPixmap);
+    // Display error message directly on the video surface instead of showing a message box
+    m_videoWidget->showMessage("Connection Error: Failed to connect to RTSP stream.\n"
+                               "URL: " + m_rtspUrl + "\n"
+                               "Press R to reconnect or Q to quit.");
 
     // Log RTSP connection failure
     qCWarning(mainWindow) << "RTSP connection failed - server may be unavailable";
@@ -210,14 +260,21 @@ void MainWindow::handleConnectionError()
     QTimer::singleShot(5000, this, &MainWindow::connectToStream);
 }
 
+void MainWindow::setStreamUrl(const QString &url)
+{
+    m_rtspUrl = url;
+    qCInfo(mainWindow) << "Stream URL set to:" << m_rtspUrl;
+}
+
 void MainWindow::connectToStream()
 {
-#ifndef OPENCV_ENABLED
-    qCCritical(mainWindow) << "OpenCV not available - RTSP streaming disabled";
-    QMessageBox::critical(this, "OpenCV Not Available",
-                          "OpenCV was not found during compilation. RTSP streaming is disabled. Please install OpenCV and rebuild the application.");
-    return;
-#endif
+    // Synthetic and .kraw replay sources work without OpenCV, network streams don't
+    if (!CaptureSource::supportsUrl(m_rtspUrl)) {
+        qCCritical(mainWindow) << "OpenCV not available - cannot open" << m_rtspUrl;
+        QMessageBox::critical(this, "OpenCV Not Available",
+                              "OpenCV was not found during compilation. RTSP streaming is disabled. Please install OpenCV and rebuild the application.");
+        return;
+    }
 
     qCInfo(mainWindow) << "Connecting to RTSP stream:" << m_rtspUrl;
 
@@ -230,8 +287,8 @@ void MainWindow::connectToStream()
         qCWarning(mainWindow) << "RTSP streamer already running";
     }
 
-    // Clear any existing text on the video label
-    m_videoLabel->setText("");
+    // Clear any existing message on the video surface
+    m_videoWidget->clear();
 }
 
 void MainWindow::disconnectFromStream()
@@ -243,11 +300,13 @@ void MainWindow::disconnectFromStream()
     }
 
     // Clear the image
-    m_videoLabel->setPixmap(QPixmap());
+    m_videoWidget->clear();
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event)
 {
+    GUI_WATCHDOG_SCOPE("MainWindow::keyPressEvent");
+
     if (event->key() == Qt::Key_Escape) {
         // Quit application when Escape is pressed
         close();
@@ -263,6 +322,10 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
     } else if (event->key() == Qt::Key_Q) {
         // Also quit on Q
         close();
+    } else if (event->key() == Qt::Key_H) {
+        // Toggle the performance overlay on H
+        m_hud->setVisible(!m_hud->isVisible());
+        m_hud->raise();
     } else if (event->key() == Qt::Key_R) {
         // Reconnect to stream on R
         disconnectFromStream();
@@ -283,15 +346,17 @@ void MainWindow::updateButtonStyle()
                 "  color: white;"
                 "  background-color: %1;"
                 "  border: 2px solid white;"
-                "  border-radius: 10px;"
-                "  font: bold 16pt 'Arial';"
-                "  padding: 10px;"
+                "  border-radius: %3px;"
+                "  font: bold %4pt 'Arial';"
+                "  padding: %3px;"
                 "}"
                 "QPushButton:hover {"
                 "  background-color: %2;"
                 "}")
             .arg(bgColor)
             .arg(m_isAutoMode ? "rgba(0, 150, 0, 200)" : "rgba(150, 0, 0, 200)")
+            .arg(scaledSize(10))
+            .arg(scaledSize(16))
         );
 
     m_toggleButton->setText(text);
@@ -299,6 +364,8 @@ void MainWindow::updateButtonStyle()
 
 void MainWindow::toggleAutoManual()
 {
+    GUI_WATCHDOG_SCOPE("MainWindow::toggleAutoManual");
+
     // Toggle the mode
     m_isAutoMode = !m_isAutoMode;
 
@@ -314,37 +381,46 @@ void MainWindow::toggleAutoManual()
 
 void MainWindow::updateButtonsPosition()
 {
+    // Positions are laid out for an upright display and then mapped to the
+    // display orientation, so the rotated overlay ends up where it belongs
+
     // Position toggle button in bottom right with margin
-    const int margin = 30;
+    const int margin = scaledSize(30);
     int x = width() - m_toggleButton->width() - margin;
     int y = height() - m_toggleButton->height() - margin;
 
-    m_toggleButton->move(x, y);
+    m_toggleButton->move(overlayPosition(QPoint(x, y), m_toggleButton->size()));
 
     // Ensure button is visible and on top
     m_toggleButton->raise();
     m_toggleButton->show();
 
     // Position distance map in top right corner
-    m_distanceMap->move(width() - m_distanceMap->width() - margin, margin);
+    m_distanceMap->move(overlayPosition(QPoint(width() - m_distanceMap->width() - margin, margin),
+                                        m_distanceMap->size()));
     m_distanceMap->raise();
 
+    // Position the performance overlay in the top left corner
+    m_hud->move(overlayPosition(QPoint(margin, margin), m_hud->size()));
+    m_hud->raise();
+
     // Position arrow buttons in bottom left corner
     // Creating a diamond/cross pattern
-    const int arrowMargin = 20;
+    const int arrowMargin = scaledSize(20);
     const int buttonSize = m_arrowButtons[0]->width();
+    const QSize arrowSize = m_arrowButtons[0]->size();
 
     // Up arrow (top position)
-    m_arrowButtons[0]->move(margin + buttonSize+10, height() - 2*buttonSize - margin - arrowMargin+20);
+    m_arrowButtons[0]->move(overlayPosition(QPoint(margin + buttonSize + scaledSize(10), height() - 2*buttonSize - margin - arrowMargin + scaledSize(20)), arrowSize));
 
     // Right arrow (right position)
-    m_arrowButtons[1]->move(margin + 2*buttonSize+50 - arrowMargin, height() - buttonSize - margin - arrowMargin/2);
+    m_arrowButtons[1]->move(overlayPosition(QPoint(margin + 2*buttonSize + scaledSize(50) - arrowMargin, height() - buttonSize - margin - arrowMargin/2), arrowSize));
 
     // Down arrow (bottom position)
-    m_arrowButtons[2]->move(margin + buttonSize+10, height() - buttonSize - margin - 10);
+    m_arrowButtons[2]->move(overlayPosition(QPoint(margin + buttonSize + scaledSize(10), height() - buttonSize - margin - scaledSize(10)), arrowSize));
 
     // Left arrow (left position)
-    m_arrowButtons[3]->move(margin, height() - buttonSize - margin - arrowMargin/2);
+    m_arrowButtons[3]->move(overlayPosition(QPoint(margin, height() - buttonSize - margin - arrowMargin/2), arrowSize));
 
     // Make sure all arrows are on top
     for (QPushButton* button : m_arrowButtons) {
@@ -352,32 +428,35 @@ void MainWindow::updateButtonsPosition()
     }
 }
 
-QPushButton* MainWindow::createArrowButton(const QString& direction)
+OverlayButton* MainWindow::createArrowButton(const QString& direction)
 {
-    QPushButton* button = new QPushButton(direction, this);
-    button->setMinimumSize(60, 60);
+    OverlayButton* button = new OverlayButton(direction, this);
+    button->setMinimumSize(scaledSize(60), scaledSize(60));
     button->setFocusPolicy(Qt::NoFocus);
     button->setStyleSheet(
-        "QPushButton {"
+        QString("QPushButton {"
         "  color: white;"
         "  background-color: rgba(50, 50, 50, 160);"
         "  border: 2px solid white;"
-        "  border-radius: 30px;"
-        "  font: bold 24pt;"
+        "  border-radius: %1px;"
+        "  font: bold %2pt;"
         "}"
         "QPushButton:hover {"
         "  background-color: rgba(80, 80, 80, 200);"
         "}"
         "QPushButton:pressed {"
         "  background-color: rgba(100, 100, 100, 220);"
-        "}"
+        "}")
+            .arg(scaledSize(30))
+            .arg(scaledSize(24))
         );
 
     // Store the direction as a property
     button->setProperty("direction", direction);
 
-    // Connect button click signal
-    connect(button, &QPushButton::clicked, this, &MainWindow::arrowButtonClicked);
+    // The direction is held while the button is down
+    connect(button, &QPushButton::pressed, this, &MainWindow::arrowButtonPressed);
+    connect(button, &QPushButton::released, this, &MainWindow::arrowButtonReleased);
 
     return button;
 }
@@ -390,47 +469,74 @@ void MainWindow::updateArrowButtonsVisibility()
     }
 }
 
-void MainWindow::arrowButtonClicked()
+void MainWindow::arrowButtonPressed()
+{
+    GUI_WATCHDOG_SCOPE("MainWindow::arrowButtonPressed");
+    setArrowButtonHeld(qobject_cast<QPushButton*>(sender()), true);
+}
+
+void MainWindow::arrowButtonReleased()
+{
+    GUI_WATCHDOG_SCOPE("MainWindow::arrowButtonReleased");
+    setArrowButtonHeld(qobject_cast<QPushButton*>(sender()), false);
+}
+
+void MainWindow::setArrowButtonHeld(QPushButton *button, bool held)
 {
-    QPushButton* button = qobject_cast<QPushButton*>(sender());
     if (!button)
         return;
 
-    QString direction = button->property("direction").toString();
+    QString directionName = arrowDirectionName(button->property("direction").toString());
 
-    qCInfo(mainWindow) << "Arrow button clicked:" << direction;
+    qCInfo(mainWindow) << "Arrow button" << (held ? "pressed:" : "released:") << directionName;
 
+    // Held for as long as the button is down
+    if (!directionName.isEmpty() && m_nativeController)
+        m_nativeController->setDirectionHeld(directionName, held);
+}
+
+QString MainWindow::arrowDirectionName(const QString &arrowSymbol)
+{
     // Convert arrow symbols to direction names
-    QString directionName;
-    if (direction == "↑") {
-        directionName = "UP";
-    } else if (direction == "→") {
-        directionName = "RIGHT";
-    } else if (direction == "↓") {
-        directionName = "DOWN";
-    } else if (direction == "←") {
-        directionName = "LEFT";
-    }
+    if (arrowSymbol == "↑")
+        return "UP";
+    if (arrowSymbol == "→")
+        return "RIGHT";
+    if (arrowSymbol == "↓")
+        return "DOWN";
+    if (arrowSymbol == "←")
+        return "LEFT";
+    return QString();
+}
 
-    // Send command to server
-    if (!directionName.isEmpty() && m_nativeController) {
-        m_nativeController->sendButtonPress(directionName);
-        qCInfo(mainWindow) << "Sent button command to server:" << directionName;
+QPushButton *MainWindow::arrowButton(const QString &directionName) const
+{
+    for (QPushButton* button : m_arrowButtons) {
+        if (arrowDirectionName(button->property("direction").toString()) == directionName)
+            return button;
     }
+    return nullptr;
 }
 
 void MainWindow::resizeEvent(QResizeEvent *event)
 {
+    GUI_WATCHDOG_SCOPE("MainWindow::resizeEvent");
+
     QMainWindow::resizeEvent(event);
     updateButtonsPosition();
+
+    // Have the capture thread produce frames at the size and orientation they are shown at
+    m_rtspStreamer->setDisplayTransform(m_videoWidget->size(), m_displayRotation == 180);
 }
 
 void MainWindow::mousePressEvent(QMouseEvent *event)
 {
+    GUI_WATCHDOG_SCOPE("MainWindow::mousePressEvent");
+
     // Only process left mouse button clicks in AUTO mode
     if (event->button() == Qt::LeftButton && m_isAutoMode) {
-        // Get click coordinates relative to the video display
-        QPoint clickPos = event->pos();
+        // Get click coordinates relative to the upright video display
+        QPoint clickPos = displayToLogical(event->pos());
 
         // Normalize coordinates based on RTSP stream dimensions
         QPointF normalizedCoord = normalizeCoordinates(clickPos);
@@ -444,8 +550,9 @@ void MainWindow::mousePressEvent(QMouseEvent *event)
                            << "normalized:" << normalizedCoord.x() << "," << normalizedCoord.y()
                            << "stream:" << streamX << "," << streamY;
 
-        // Send normalized touch coordinates to server
+        // Send normalized touch coordinates to server, in one datagram
         if (m_nativeController) {
+            NativeController::Batch batch(m_nativeController);
             m_nativeController->sendTouchCoordinate(streamX, streamY);
             m_nativeController->sendModeChange(m_isAutoMode);
         }
@@ -460,22 +567,25 @@ void MainWindow::mousePressEvent(QMouseEvent *event)
 void MainWindow::setupNativeController()
 {
     m_nativeController = new NativeController(this);
+    m_hud->setController(m_nativeController);
 
     // Connect signals for local UI updates
     connect(m_nativeController, &NativeController::directionPressed, this, &MainWindow::handleDirectionPress);
+    connect(m_nativeController, &NativeController::directionReleased, this, &MainWindow::handleDirectionRelease);
     connect(m_nativeController, &NativeController::modeTogglePressed, this, &MainWindow::handleModeToggle);
+    connect(m_nativeController, &NativeController::scanReady, this, &MainWindow::handleScanReady);
 
     // Debug connections
     connect(m_nativeController, &NativeController::controllerStarted,
-            []() { qDebug() << "Native controller started as CLIENT"; });
+            []() { qCDebug(mainWindow) << "Native controller started as CLIENT"; });
     connect(m_nativeController, &NativeController::serverConnected,
-            []() { qDebug() << "Connected to server"; });
+            []() { qCDebug(mainWindow) << "Connected to server"; });
     connect(m_nativeController, &NativeController::serverDisconnected,
-            []() { qDebug() << "Disconnected from server"; });
-    connect(m_nativeController, &NativeController::commandSent,
-            [](const QString &command) { qDebug() << "Command sent to server:" << command; });
+            []() { qCDebug(mainWindow) << "Disconnected from server"; });
     connect(m_nativeController, &NativeController::errorOccurred,
-            [](const QString &error) { qDebug() << "Controller Error:" << error; });
+            [](const QString &error) { qCDebug(mainWindow) << "Controller Error:" << error; });
+    connect(m_nativeController, &NativeController::emergencyStopAcknowledged,
+            [](double rttMs) { qCInfo(mainWindow) << "Emergency stop acknowledged, RTT" << rttMs << "ms"; });
 
     // Set network configuration
     m_nativeController->setServerAddress(m_tcpAddress);
@@ -503,38 +613,33 @@ void MainWindow::setupNativeController()
 
 void MainWindow::handleDirectionPress(const QString &direction)
 {
-    qCInfo(mainWindow) << "Direction pressed:" << direction;
+    GUI_WATCHDOG_SCOPE("MainWindow::handleDirectionPress");
 
-    // Only handle directional buttons in MANUAL mode
-    if (m_isAutoMode == false) {
-        // Map direction names to arrow symbols
-        QString arrowSymbol;
-        if (direction == "UP") {
-            arrowSymbol = "↑";
-        } else if (direction == "DOWN") {
-            arrowSymbol = "↓";
-        } else if (direction == "LEFT") {
-            arrowSymbol = "←";
-        } else if (direction == "RIGHT") {
-            arrowSymbol = "→";
-        }
+    qCDebug(mainWindow) << "Direction pressed:" << direction;
 
-        // Find and simulate a click on the appropriate arrow button
-        for (QPushButton* button : m_arrowButtons) {
-            QString buttonDirection = button->property("direction").toString();
-            if (buttonDirection == arrowSymbol) {
-                // Simulate button click
-                button->click();
-                qCInfo(mainWindow) << "Simulated click on arrow button:" << arrowSymbol;
-                break;
-            }
-        }
+    // Only handle directional buttons in MANUAL mode. The command has been
+    // sent already, so only show the matching arrow button as pressed.
+    if (m_isAutoMode == false) {
+        if (QPushButton *button = arrowButton(direction))
+            button->setDown(true);
     }
 }
 
+void MainWindow::handleDirectionRelease(const QString &direction)
+{
+    GUI_WATCHDOG_SCOPE("MainWindow::handleDirectionRelease");
+
+    qCDebug(mainWindow) << "Direction released:" << direction;
+
+    if (QPushButton *button = arrowButton(direction))
+        button->setDown(false);
+}
+
 void MainWindow::handleModeToggle()
 {
-    qDebug() << "Mode toggle pressed";
+    GUI_WATCHDOG_SCOPE("MainWindow::handleModeToggle");
+
+    qCDebug(mainWindow) << "Mode toggle pressed";
     toggleAutoManual();
 
     // Send mode change to server
@@ -545,7 +650,7 @@ void MainWindow::handleModeToggle()
 
 void MainWindow::handleTouchCoordinate(int x, int y)
 {
-    qDebug() << "Touch coordinate received:" << x << "," << y;
+    qCDebug(mainWindow) << "Touch coordinate received:" << x << "," << y;
 
     // Only process touch coordinates if in AUTO mode
     if (m_isAutoMode) {
@@ -560,63 +665,95 @@ void MainWindow::handleTouchCoordinate(int x, int y)
             //m_distanceMap->highlightPoint(x, y);
         }
 
-        qDebug() << "Sent touch coordinate to server:" << x << "," << y;
+        qCDebug(mainWindow) << "Sent touch coordinate to server:" << x << "," << y;
     }
 }
 
-QPointF MainWindow::normalizeCoordinates(const QPoint &screenCoord) const
+void MainWindow::handleScanReady()
 {
-    // Get the video label rectangle
-    QRect videoRect = m_videoLabel->geometry();
+    // Only the newest scan is drawn; any that arrived meanwhile are skipped
+    if (const RadarScan *scan = m_nativeController->takeScan())
+        m_distanceMap->setScan(*scan);
+}
 
-    // Get the current frame to determine aspect ratio
-    QImage currentFrame = m_rtspStreamer->getCurrentFrame();
-    if (currentFrame.isNull()) {
-        // If no frame is available, use stream dimensions
-        QSize streamSize = m_rtspStreamer->getStreamSize();
-        if (streamSize.isEmpty()) {
+QPointF MainWindow::normalizeCoordinates(const QPoint &screenCoord) const
+{
+    // Use the stream dimensions to determine aspect ratio; frames may already
+    // be scaled to the display size by the capture thread
+    QSize frameSize = m_rtspStreamer->getStreamSize();
+    if (frameSize.isEmpty()) {
+        // Fall back to the current frame if the stream size isn't known
+        frameSize = m_rtspStreamer->getCurrentFrame().size();
+        if (frameSize.isEmpty()) {
             // Return normalized coordinates based on screen position if no stream info
             return QPointF(static_cast<double>(screenCoord.x()) / width(),
                            static_cast<double>(screenCoord.y()) / height());
         }
-        currentFrame = QImage(streamSize, QImage::Format_RGB888);
     }
 
-    // Calculate the actual video area within the label (considering aspect ratio)
-    QSize frameSize = currentFrame.size();
-    QSize labelSize = m_videoLabel->size();
-
-    // Calculate scaling to fit the frame in the label while maintaining aspect ratio
-    double frameAspect = static_cast<double>(frameSize.width()) / frameSize.height();
-    double labelAspect = static_cast<double>(labelSize.width()) / labelSize.height();
-
-    QRect actualVideoRect;
-    if (frameAspect > labelAspect) {
-        // Frame is wider than label - fit to width
-        int scaledHeight = static_cast<int>(labelSize.width() / frameAspect);
-        int yOffset = (labelSize.height() - scaledHeight) / 2;
-        actualVideoRect = QRect(videoRect.x(), videoRect.y() + yOffset,
-                                labelSize.width(), scaledHeight);
-    } else {
-        // Frame is taller than label - fit to height
-        int scaledWidth = static_cast<int>(labelSize.height() * frameAspect);
-        int xOffset = (labelSize.width() - scaledWidth) / 2;
-        actualVideoRect = QRect(videoRect.x() + xOffset, videoRect.y(),
-                                scaledWidth, labelSize.height());
+    return ::normalizeCoordinates(screenCoord, m_videoWidget->geometry(), frameSize);
+}
+
+void MainWindow::setDisplayOrientation(int rotation, qreal overlayScale)
+{
+    if (rotation != 0 && rotation != 180) {
+        qCWarning(mainWindow) << "Unsupported display rotation" << rotation << "- only 0 and 180 are supported";
+        return;
     }
 
-    // Convert screen coordinates to coordinates within the actual video area
-    QPoint relativeCoord = screenCoord - actualVideoRect.topLeft();
+    m_displayRotation = rotation;
+    m_overlayScale = overlayScale > 0 ? overlayScale : 1.0;
+
+    qCInfo(mainWindow) << "Display orientation - rotation:" << m_displayRotation << "overlay scale:" << m_overlayScale;
 
-    // Normalize to 0.0-1.0 range
-    double normalizedX = static_cast<double>(relativeCoord.x()) / actualVideoRect.width();
-    double normalizedY = static_cast<double>(relativeCoord.y()) / actualVideoRect.height();
+    // Resize the overlay controls for the new scale
+    m_distanceMap->setFixedSize(scaledSize(200), scaledSize(200));
+    m_toggleButton->setMinimumSize(scaledSize(150), scaledSize(80));
+    for (OverlayButton* button : m_arrowButtons) {
+        button->setMinimumSize(scaledSize(60), scaledSize(60));
+    }
+    updateButtonStyle();
 
-    // Clamp to valid range
-    normalizedX = qBound(0.0, normalizedX, 1.0);
-    normalizedY = qBound(0.0, normalizedY, 1.0);
+    applyDisplayOrientation();
+}
+
+void MainWindow::applyDisplayOrientation()
+{
+    const bool rotated = m_displayRotation == 180;
+
+    m_videoWidget->setRotated180(rotated);
+    m_toggleButton->setRotated180(rotated);
+    for (OverlayButton* button : m_arrowButtons) {
+        button->setRotated180(rotated);
+    }
+    m_distanceMap->setDisplayTransform(rotated, m_overlayScale);
+    m_hud->setDisplayTransform(rotated, m_overlayScale);
+
+    m_rtspStreamer->setDisplayTransform(m_videoWidget->size(), rotated);
+    updateButtonsPosition();
+}
+
+int MainWindow::scaledSize(int value) const
+{
+    return qRound(value * m_overlayScale);
+}
+
+QPoint MainWindow::overlayPosition(const QPoint &logicalPos, const QSize &size) const
+{
+    if (m_displayRotation != 180)
+        return logicalPos;
+
+    // Mirror the widget's rectangle through the window centre
+    return QPoint(width() - logicalPos.x() - size.width(),
+                  height() - logicalPos.y() - size.height());
+}
+
+QPoint MainWindow::displayToLogical(const QPoint &pos) const
+{
+    if (m_displayRotation != 180)
+        return pos;
 
-    return QPointF(normalizedX, normalizedY);
+    return QPoint(width() - 1 - pos.x(), height() - 1 - pos.y());
 }
 
 void MainWindow::setNetworkConfiguration(const QString &address, quint16 rtspPort, quint16 tcpPort, quint16 udpPort)
@@ -0,0 +1,278 @@
+#include "metricsserver.h"
+#include "rtspstreamer.h"
+#include "nativecontroller.h"
+#include "guiwatchdog.h"
+#include "latencyprobe.h"
+#include "processusage.h"
+#include "asynclogger.h"
+#include <QDebug>
+#include <QTcpSocket>
+
+MetricsServer::MetricsServer(QObject *parent) : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(quint16 port)
+{
+    // Never reachable from the network: scraped by a local agent
+    if (!m_server.listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Metrics server cannot listen on port" << port << ":" << m_server.errorString();
+        return false;
+    }
+    qInfo() << "Metrics available at http://127.0.0.1:" << m_server.serverPort() << "/metrics";
+    return true;
+}
+
+quint16 MetricsServer::port() const
+{
+    return m_server.serverPort();
+}
+
+void MetricsServer::setStreamer(RTSPStreamer *streamer)
+{
+    m_streamer = streamer;
+}
+
+void MetricsServer::setController(NativeController *controller)
+{
+    m_controller = controller;
+}
+
+void MetricsServer::setWatchdog(GuiWatchdog *watchdog)
+{
+    m_watchdog = watchdog;
+}
+
+void MetricsServer::setLatencyProbe(LatencyProbe *probe)
+{
+    m_latencyProbe = probe;
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_requests.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsServer::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_requests.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MetricsServer::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_requests.contains(socket))
+        return;
+
+    QByteArray &request = m_requests[socket];
+    request += socket->readAll();
+    if (request.size() > MaxRequestBytes) {
+        m_requests.remove(socket);
+        socket->abort();
+        return;
+    }
+    if (!request.contains("\r\n\r\n"))
+        return; // Headers incomplete
+
+    QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    m_requests.remove(socket);
+
+    if (requestLine.size() < 2 || requestLine[0] != "GET") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+    } else if (requestLine[1] == "/metrics") {
+        respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", metrics());
+    } else {
+        respond(socket, "404 Not Found", "text/plain", "Metrics are at /metrics\n");
+    }
+}
+
+void MetricsServer::respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType,
+                            const QByteArray &body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    socket->write(response + body);
+    socket->disconnectFromHost();
+}
+
+QByteArray MetricsServer::metrics() const
+{
+    QByteArray out;
+    out.reserve(8192);
+
+    if (m_streamer) {
+        StreamStats stats = m_streamer->stats();
+        writeHeader(out, "kria_frames_total", "counter", "Frames by pipeline stage");
+        writeValue(out, "kria_frames_total", "stage=\"grabbed\"", stats.framesGrabbed);
+        writeValue(out, "kria_frames_total", "stage=\"retrieved\"", stats.framesRetrieved);
+        writeValue(out, "kria_frames_total", "stage=\"converted\"", stats.framesConverted);
+        writeValue(out, "kria_frames_total", "stage=\"displayed\"", stats.framesDisplayed);
+
+        writeHeader(out, "kria_frames_dropped_total", "counter", "Frames skipped, failed or replaced before being displayed");
+        writeValue(out, "kria_frames_dropped_total", QByteArray(), stats.framesDropped);
+
+        writeHeader(out, "kria_stream_reconnects_total", "counter", "Capture source reconnects");
+        writeValue(out, "kria_stream_reconnects_total", QByteArray(), stats.reconnects);
+
+        writeHeader(out, "kria_stream_time_to_first_frame_seconds", "gauge",
+                    "Time from connecting to the first published frame, last connection");
+        writeValue(out, "kria_stream_time_to_first_frame_seconds", QByteArray(), stats.timeToFirstFrameNs / 1e9);
+
+        writeHeader(out, "kria_stream_up", "gauge", "1 while the capture thread is streaming");
+        writeValue(out, "kria_stream_up", QByteArray(), m_streamer->isStreaming() ? 1 : 0);
+
+        const PipelineLatency &latency = m_streamer->latency();
+        writeHeader(out, "kria_pipeline_latency_seconds", "summary", "Frame latency per pipeline stage");
+        for (int i = 0; i < PipelineLatency::StageCount; ++i) {
+            PipelineLatency::Stage stage = static_cast<PipelineLatency::Stage>(i);
+            writeSummary(out, "kria_pipeline_latency_seconds",
+                         QByteArray("stage=\"") + PipelineLatency::stageName(stage) + "\"",
+                         latency.histogram(stage));
+        }
+    }
+
+    if (m_latencyProbe) {
+        writeHeader(out, "kria_glass_to_glass_latency_seconds", "summary",
+                    "Age of the timestamp stamped into painted frames");
+        writeSummary(out, "kria_glass_to_glass_latency_seconds", QByteArray(), m_latencyProbe->histogram());
+    }
+
+    if (m_controller) {
+        ControllerStats stats = m_controller->stats();
+        writeHeader(out, "kria_controller_commands_total", "counter", "Commands sent to the server by type");
+        writeValue(out, "kria_controller_commands_total", "type=\"button\"", stats.buttonCommands);
+        writeValue(out, "kria_controller_commands_total", "type=\"touch\"", stats.touchCommands);
+        writeValue(out, "kria_controller_commands_total", "type=\"mode\"", stats.modeCommands);
+        writeValue(out, "kria_controller_commands_total", "type=\"state\"", stats.stateCommands);
+        writeValue(out, "kria_controller_commands_total", "type=\"stop\"", stats.stopCommands);
+
+        writeHeader(out, "kria_controller_preempted_total", "counter", "Queued motion commands dropped by an emergency stop");
+        writeValue(out, "kria_controller_preempted_total", QByteArray(), stats.preemptedCommands);
+
+        writeHeader(out, "kria_controller_sent_bytes_total", "counter", "Bytes sent to the server");
+        writeValue(out, "kria_controller_sent_bytes_total", "transport=\"udp\"", stats.udpBytesSent);
+        writeValue(out, "kria_controller_sent_bytes_total", "transport=\"tcp\"", stats.tcpBytesSent);
+
+        writeHeader(out, "kria_controller_send_errors_total", "counter", "Commands that failed to send");
+        writeValue(out, "kria_controller_send_errors_total", QByteArray(), stats.sendErrors);
+
+        writeHeader(out, "kria_controller_tcp_reconnects_total", "counter", "TCP reconnect attempts");
+        writeValue(out, "kria_controller_tcp_reconnects_total", QByteArray(), stats.tcpReconnects);
+
+        writeHeader(out, "kria_controller_acks_total", "counter", "UDP commands acknowledged by the server");
+        writeValue(out, "kria_controller_acks_total", QByteArray(), stats.acksReceived);
+
+        writeHeader(out, "kria_controller_lost_total", "counter", "UDP commands never acknowledged");
+        writeValue(out, "kria_controller_lost_total", QByteArray(), stats.commandsLost);
+
+        writeHeader(out, "kria_controller_retransmissions_total", "counter", "UDP commands sent again after a timeout");
+        writeValue(out, "kria_controller_retransmissions_total", QByteArray(), stats.retransmissions);
+
+        writeHeader(out, "kria_controller_loss_ratio", "gauge", "Recent fraction of unacknowledged UDP datagrams");
+        writeValue(out, "kria_controller_loss_ratio", QByteArray(), stats.lossRate);
+
+        writeHeader(out, "kria_controller_rtt_seconds", "summary", "Round-trip time of acknowledged UDP commands");
+        writeSummary(out, "kria_controller_rtt_seconds", QByteArray(), m_controller->roundTripTime());
+
+        writeHeader(out, "kria_controller_input_to_wire_seconds", "summary",
+                    "Time from queuing a command to handing it to the socket");
+        writeSummary(out, "kria_controller_input_to_wire_seconds", QByteArray(), m_controller->inputToWire());
+
+        writeHeader(out, "kria_controller_queue_overflows_total", "counter", "Commands dropped because the link queue was full");
+        writeValue(out, "kria_controller_queue_overflows_total", QByteArray(), stats.queueOverflows);
+
+        writeHeader(out, "kria_controller_batches_total", "counter", "Datagrams/TCP writes carrying several commands");
+        writeValue(out, "kria_controller_batches_total", QByteArray(), stats.batches);
+        writeHeader(out, "kria_controller_batched_commands_total", "counter", "Commands sent in batches");
+        writeValue(out, "kria_controller_batched_commands_total", QByteArray(), stats.batchedCommands);
+
+        writeHeader(out, "kria_controller_tcp_queue_depth", "gauge", "Commands waiting for the TCP connection");
+        writeValue(out, "kria_controller_tcp_queue_depth", QByteArray(), stats.tcpQueueDepth);
+        writeHeader(out, "kria_controller_tcp_queue_dropped_total", "counter",
+                    "Queued TCP commands dropped as superseded, stale or overflowing");
+        writeValue(out, "kria_controller_tcp_queue_dropped_total", QByteArray(), stats.tcpQueueDropped);
+        writeHeader(out, "kria_controller_tcp_replayed_total", "counter", "Queued TCP commands sent after reconnecting");
+        writeValue(out, "kria_controller_tcp_replayed_total", QByteArray(), stats.tcpReplayed);
+        writeHeader(out, "kria_controller_tcp_reconnect_seconds", "gauge", "Duration of the last TCP outage");
+        writeValue(out, "kria_controller_tcp_reconnect_seconds", QByteArray(), stats.tcpReconnectNs / 1e9);
+
+        writeHeader(out, "kria_controller_scans_total", "counter", "Telemetry scans received from the server");
+        writeValue(out, "kria_controller_scans_total", "result=\"ok\"", stats.scansReceived);
+        writeValue(out, "kria_controller_scans_total", "result=\"malformed\"", stats.scansMalformed);
+    }
+
+    if (m_watchdog) {
+        writeHeader(out, "kria_gui_event_loop_lag_seconds", "summary", "GUI event loop dispatch lag");
+        writeSummary(out, "kria_gui_event_loop_lag_seconds", QByteArray(), m_watchdog->eventLoopLag());
+
+        writeHeader(out, "kria_gui_handler_duration_seconds", "summary", "Duration of GUI thread handlers");
+        for (const GuiWatchdog::Handler *handler = GuiWatchdog::handlers(); handler; handler = handler->next()) {
+            writeSummary(out, "kria_gui_handler_duration_seconds",
+                         QByteArray("handler=\"") + handler->name() + "\"", handler->histogram());
+        }
+
+        writeHeader(out, "kria_gui_stalls_total", "counter", "GUI thread stalls over the threshold");
+        writeValue(out, "kria_gui_stalls_total", QByteArray(), m_watchdog->stallCount());
+    }
+
+    writeHeader(out, "kria_log_records_total", "counter", "Log records written by the async logger");
+    writeValue(out, "kria_log_records_total", QByteArray(), AsyncLogger::writtenRecords());
+    writeHeader(out, "kria_log_records_dropped_total", "counter", "Log records dropped because the ring was full");
+    writeValue(out, "kria_log_records_dropped_total", QByteArray(), AsyncLogger::droppedRecords());
+
+    ProcessUsage usage = ProcessUsage::current();
+    writeHeader(out, "process_cpu_seconds_total", "counter", "Total user and system CPU time");
+    writeValue(out, "process_cpu_seconds_total", QByteArray(), usage.cpuSeconds);
+    writeHeader(out, "process_resident_memory_bytes", "gauge", "Resident memory size");
+    writeValue(out, "process_resident_memory_bytes", QByteArray(), static_cast<double>(usage.residentBytes));
+
+    return out;
+}
+
+void MetricsServer::writeHeader(QByteArray &out, const char *name, const char *type, const char *help)
+{
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void MetricsServer::writeValue(QByteArray &out, const char *name, const QByteArray &labels, double value)
+{
+    out += name;
+    if (!labels.isEmpty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += QByteArray::number(value, 'g', 15);
+    out += '\n';
+}
+
+void MetricsServer::writeSummary(QByteArray &out, const char *name, const QByteArray &labels,
+                                 const LatencyHistogram &histogram)
+{
+    LatencyHistogram::Summary s = histogram.summary();
+    QByteArray prefix = labels.isEmpty() ? QByteArray() : labels + ",";
+
+    const struct { const char *quantile; qint64 value; } quantiles[] = {
+        { "0.5", s.p50 }, { "0.9", s.p90 }, { "0.99", s.p99 }, { "0.999", s.p999 }
+    };
+    for (const auto &q : quantiles)
+        writeValue(out, name, prefix + "quantile=\"" + q.quantile + "\"", q.value / 1e9);
+
+    QByteArray base(name);
+    writeValue(out, (base + "_sum").constData(), labels, s.sum / 1e9);
+    writeValue(out, (base + "_count").constData(), labels, static_cast<double>(s.count));
+}
@@ -1,15 +1,24 @@
 #include "nativecontroller.h"
+#include "guiwatchdog.h"
+#include "monotonicclock.h"
 #include <QDebug>
+#include <QLoggingCategory>
+#include <QMetaMethod>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QApplication>
 #include <QWidget>
+#include <QKeyEvent>
+
+Q_LOGGING_CATEGORY(controller, "kria.controller")
 
 NativeController::NativeController(QObject *parent)
     : QObject(parent)
-    , m_udpSocket(nullptr)
-    , m_tcpClient(nullptr)
-    , m_reconnectTimer(nullptr)
+    , m_linkThread(nullptr)
+    , m_link(nullptr)
+    , m_sampler(nullptr)
+    , m_sampling(true)
+    , m_shownDirections(0)
 #ifdef QT_GAMEPAD_ENABLED
     , m_gamepad(nullptr)
 #endif
@@ -20,21 +29,27 @@ NativeController::NativeController(QObject *parent)
     , m_gamepadEnabled(true)
     , m_udpEnabled(true)
     , m_tcpEnabled(false)
-    , m_autoReconnect(true)
 {
-    // Initialize UDP socket for sending commands
-    m_udpSocket = new QUdpSocket(this);
-    
-    // Initialize TCP client for persistent connection
-    m_tcpClient = new QTcpSocket(this);
-    connect(m_tcpClient, &QTcpSocket::connected, this, &NativeController::onTcpConnected);
-    connect(m_tcpClient, &QTcpSocket::disconnected, this, &NativeController::onTcpDisconnected);
-    connect(m_tcpClient, &QTcpSocket::errorOccurred, this, &NativeController::onTcpError);
-    
-    // Setup reconnect timer
-    m_reconnectTimer = new QTimer(this);
-    m_reconnectTimer->setInterval(5000); // Try reconnect every 5 seconds
-    connect(m_reconnectTimer, &QTimer::timeout, this, &NativeController::reconnectToServer);
+    // Socket I/O and command encoding get their own thread and event loop
+    m_linkThread = new QThread(this);
+    m_linkThread->setObjectName("ControlLink");
+    m_link = new ControlLink;
+    m_link->moveToThread(m_linkThread);
+    connect(m_linkThread, &QThread::finished, m_link, &QObject::deleteLater);
+
+    connect(m_link, &ControlLink::serverConnected, this, &NativeController::serverConnected);
+    connect(m_link, &ControlLink::serverDisconnected, this, &NativeController::serverDisconnected);
+    connect(m_link, &ControlLink::commandSent, this, &NativeController::commandSent);
+    connect(m_link, &ControlLink::errorOccurred, this, &NativeController::errorOccurred);
+    connect(m_link, &ControlLink::roundTripTimeMeasured, this, &NativeController::roundTripTimeMeasured);
+    connect(m_link, &ControlLink::linkQualityChanged, this, &NativeController::linkQualityChanged);
+    connect(m_link, &ControlLink::emergencyStopAcknowledged, this, &NativeController::emergencyStopAcknowledged);
+    connect(m_link, &ControlLink::scanReady, this, &NativeController::scanReady);
+
+    m_linkThread->start();
+
+    m_sampler = new InputSampler(this);
+    connect(m_sampler, &InputSampler::sampled, this, &NativeController::onInputSampled);
     
     // Setup gamepad
     setupGamepad();
@@ -43,31 +58,42 @@ NativeController::NativeController(QObject *parent)
 NativeController::~NativeController()
 {
     stopController();
+
+    // Let the link close its sockets on its own thread; it is deleted there
+    // when the thread finishes
+    QMetaObject::invokeMethod(m_link, [link = m_link]() { link->stop(); }, Qt::BlockingQueuedConnection);
+    m_linkThread->quit();
+    m_linkThread->wait();
+}
+
+template <typename Function>
+void NativeController::invokeOnLink(Function f)
+{
+    // Queued, so calls reach the link thread in the order they were made
+    QMetaObject::invokeMethod(m_link, f, Qt::QueuedConnection);
+}
+
+void NativeController::waitForLink()
+{
+    // Queued behind the drain of the commands posted so far
+    QMetaObject::invokeMethod(m_link, []() {}, Qt::BlockingQueuedConnection);
 }
 
 void NativeController::startController()
 {
-    qDebug() << "Starting Native Controller as CLIENT";
-    qDebug() << "  Server Address:" << m_serverAddress;
-    qDebug() << "  UDP Port:" << m_udpPort;
-    qDebug() << "  TCP Port:" << m_tcpPort;
+    qCDebug(controller) << "Starting Native Controller as CLIENT";
+    qCDebug(controller) << "  Server Address:" << m_serverAddress;
+    qCDebug(controller) << "  UDP Port:" << m_udpPort;
+    qCDebug(controller) << "  TCP Port:" << m_tcpPort;
     
-    if (m_tcpEnabled) {
-        connectToServer();
-    }
+    invokeOnLink([link = m_link]() { link->start(); });
     
     emit controllerStarted();
 }
 
 void NativeController::stopController()
 {
-    if (m_reconnectTimer) {
-        m_reconnectTimer->stop();
-    }
-    
-    if (m_tcpClient && m_tcpClient->state() == QTcpSocket::ConnectedState) {
-        m_tcpClient->disconnectFromHost();
-    }
+    invokeOnLink([link = m_link]() { link->stop(); });
     
     emit controllerStopped();
 }
@@ -86,177 +112,274 @@ void NativeController::enableGamepadControl(bool enable)
     }
 #else
     Q_UNUSED(enable)
-    qDebug() << "Gamepad support not available - compiled without Qt Gamepad";
+    qCDebug(controller) << "Gamepad support not available - compiled without Qt Gamepad";
 #endif
 }
 
 void NativeController::enableUdpClient(bool enable)
 {
     m_udpEnabled = enable;
+    invokeOnLink([link = m_link, enable]() { link->setUdpEnabled(enable); });
 }
 
 void NativeController::enableTcpClient(bool enable)
 {
     m_tcpEnabled = enable;
-    if (enable && m_tcpClient->state() == QTcpSocket::UnconnectedState) {
-        connectToServer();
-    } else if (!enable && m_tcpClient->state() == QTcpSocket::ConnectedState) {
-        m_tcpClient->disconnectFromHost();
-    }
+    invokeOnLink([link = m_link, enable]() { link->setTcpEnabled(enable); });
 }
 
 void NativeController::setServerAddress(const QString &address)
 {
     m_serverAddress = address;
-    qDebug() << "Server address set to:" << m_serverAddress;
+    invokeOnLink([link = m_link, address]() { link->setServerAddress(address); });
+    qCDebug(controller) << "Server address set to:" << m_serverAddress;
+}
+
+void NativeController::setProtocolFormat(ControlProtocol::Format format)
+{
+    m_protocolFormat = format;
+    invokeOnLink([link = m_link, format]() { link->setProtocolFormat(format); });
+    qCDebug(controller) << "Control protocol:" << (format == ControlProtocol::Binary ? "binary" : "text");
+}
+
+ControlProtocol::Format NativeController::protocolFormat() const
+{
+    return m_protocolFormat;
 }
 
 void NativeController::setUdpPort(quint16 port)
 {
     m_udpPort = port;
+    invokeOnLink([link = m_link, port]() { link->setUdpPort(port); });
 }
 
 void NativeController::setTcpPort(quint16 port)
 {
     m_tcpPort = port;
+    invokeOnLink([link = m_link, port]() { link->setTcpPort(port); });
+}
+
+void NativeController::setTelemetryPort(quint16 port)
+{
+    invokeOnLink([link = m_link, port]() { link->setTelemetryPort(port); });
+}
+
+void NativeController::setRealtimePriority(bool enabled)
+{
+    invokeOnLink([link = m_link, enabled]() { link->setRealtimePriority(enabled); });
+}
+
+void NativeController::setBatchLatency(int ms)
+{
+    invokeOnLink([link = m_link, ms]() { link->setBatchLatency(ms); });
+}
+
+NativeController::Batch::Batch(NativeController *controller)
+    : m_controller(controller)
+{
+    if (m_controller->m_batchDepth++ == 0)
+        ++m_controller->m_batchGroup;
+}
+
+NativeController::Batch::~Batch()
+{
+    if (--m_controller->m_batchDepth == 0)
+        m_controller->m_link->wake();
 }
 
 void NativeController::sendButtonPress(const QString &button)
 {
-    QString command = QString("BUTTON:%1").arg(button);
-    
-    if (m_udpEnabled) {
-        sendUdpCommand(command);
-    }
-    
-    if (m_tcpEnabled) {
-        sendTcpCommand(command);
-    }
-    
-    emit commandSent(command);
-    qDebug() << "Sent button press:" << button;
+    ++m_stats.buttonCommands;
+
+    ControlCommand command;
+    command.type = ControlProtocol::ButtonMessage;
+    qstrncpy(command.button, button.toLatin1().constData(), sizeof(command.button));
+    post(command);
+
+    qCDebug(controller) << "Sent button press:" << button;
 }
 
 void NativeController::sendTouchCoordinate(int x, int y)
 {
-    QString command = QString("TOUCH:%1:%2").arg(x).arg(y);
-    
-    if (m_udpEnabled) {
-        sendUdpCommand(command);
-    }
-    
-    if (m_tcpEnabled) {
-        sendTcpCommand(command);
-    }
-    
-    emit commandSent(command);
-    qDebug() << "Sent touch coordinate:" << x << "," << y;
+    ++m_stats.touchCommands;
+
+    ControlCommand command;
+    command.type = ControlProtocol::TouchMessage;
+    command.x = x;
+    command.y = y;
+    post(command);
+
+    qCDebug(controller) << "Sent touch coordinate:" << x << "," << y;
 }
 
 void NativeController::sendModeChange(bool autoMode)
 {
-    QString command = QString("MODE:%1").arg(autoMode ? "AUTO" : "MANUAL");
-    
-    if (m_udpEnabled) {
-        sendUdpCommand(command);
-    }
-    
-    if (m_tcpEnabled) {
-        sendTcpCommand(command);
-    }
-    
-    emit commandSent(command);
-    qDebug() << "Sent mode change:" << (autoMode ? "AUTO" : "MANUAL");
+    ++m_stats.modeCommands;
+
+    ControlCommand command;
+    command.type = ControlProtocol::ModeMessage;
+    command.autoMode = autoMode;
+    post(command);
+
+    qCDebug(controller) << "Sent mode change:" << (autoMode ? "AUTO" : "MANUAL");
 }
 
-void NativeController::installGlobalKeyFilter(QWidget *widget)
+void NativeController::sendEmergencyStop()
 {
-    if (m_keyboardEnabled) {
-        setupKeyboardShortcuts(widget);
+    // Straight to the link, past its command queue and batching
+    m_link->emergencyStop();
+
+    // Held input would start moving again with the next tick
+    m_sampler->releaseAll();
+
+    emit emergencyStopPressed();
+    qCWarning(controller) << "Emergency stop";
+}
+
+void NativeController::setDirectionHeld(const QString &direction, bool held)
+{
+    InputSampler::Direction bit = InputSampler::directionFromName(direction);
+    if (!bit)
+        return;
+
+    if (m_sampling) {
+        m_sampler->setDirection(InputSampler::OnScreenButtons, bit, held);
+    } else if (held) {
+        sendButtonPress(direction);
     }
 }
 
-void NativeController::onTcpConnected()
+void NativeController::setInputTickRate(int hz)
 {
-    qDebug() << "Connected to TCP server at" << m_serverAddress << ":" << m_tcpPort;
-    m_reconnectTimer->stop();
-    emit serverConnected();
+    m_sampling = hz > 0;
+    m_sampler->releaseAll();
+    if (m_sampling)
+        m_sampler->setTickRate(hz);
 }
 
-void NativeController::onTcpDisconnected()
+InputSampler *NativeController::inputSampler() const
 {
-    qDebug() << "Disconnected from TCP server";
-    emit serverDisconnected();
-    
-    if (m_autoReconnect && m_tcpEnabled) {
-        m_reconnectTimer->start();
-    }
+    return m_sampler;
 }
 
-void NativeController::onTcpError(QAbstractSocket::SocketError error)
+void NativeController::onInputSampled(const InputState &state, bool edge)
 {
-    QString errorMsg = m_tcpClient->errorString();
-    qDebug() << "TCP error:" << errorMsg;
-    emit errorOccurred(errorMsg);
-    
-    if (m_autoReconnect && m_tcpEnabled && !m_reconnectTimer->isActive()) {
-        m_reconnectTimer->start();
+    ++m_stats.stateCommands;
+
+    ControlCommand command;
+    command.type = ControlProtocol::StateMessage;
+    command.directions = state.directions;
+    command.axisX = state.axisX;
+    command.axisY = state.axisY;
+    command.edge = edge;
+    post(command);
+
+    if (!edge)
+        return;
+
+    // Report direction edges to the UI
+    for (quint8 bit = InputSampler::Up; bit <= InputSampler::Right; bit <<= 1) {
+        bool held = state.directions & bit;
+        if (held == bool(m_shownDirections & bit))
+            continue;
+        QString name = QLatin1String(InputSampler::directionName(static_cast<InputSampler::Direction>(bit)));
+        if (held)
+            emit directionPressed(name);
+        else
+            emit directionReleased(name);
     }
+    m_shownDirections = state.directions;
+    qCDebug(controller) << "Input state:" << state.directions << state.axisX << state.axisY;
+}
+
+void NativeController::post(ControlCommand &command)
+{
+    command.queuedNs = MonotonicClock::timestampNs();
+    command.group = m_batchDepth > 0 ? m_batchGroup : 0;
+    // Inside a Batch the link is woken up when the Batch ends
+    if (!m_link->post(command, m_batchDepth == 0))
+        qCWarning(controller) << "Control link queue full, command dropped";
 }
 
-void NativeController::reconnectToServer()
+void NativeController::installGlobalKeyFilter(QWidget *widget)
 {
-    if (m_tcpClient->state() == QTcpSocket::UnconnectedState) {
-        qDebug() << "Attempting to reconnect to server...";
-        connectToServer();
+    if (m_keyboardEnabled) {
+        setupKeyboardShortcuts(widget);
     }
 }
 
 void NativeController::onGamepadConnected(int deviceId)
 {
     Q_UNUSED(deviceId)
-    qDebug() << "Gamepad connected";
+    qCDebug(controller) << "Gamepad connected";
 }
 
 void NativeController::onGamepadDisconnected(int deviceId)
 {
     Q_UNUSED(deviceId)
-    qDebug() << "Gamepad disconnected";
+    qCDebug(controller) << "Gamepad disconnected";
 }
 
-void NativeController::onGamepadButtonPressed(int button)
+void NativeController::onGamepadButtonChanged(int button, bool pressed)
 {
+    GUI_WATCHDOG_SCOPE("NativeController::onGamepadButtonChanged");
+
+    // Start: emergency stop, whatever else is enabled
+    if (button == 5) {
+        if (pressed)
+            sendEmergencyStop();
+        return;
+    }
+
     if (!m_gamepadEnabled) return;
     
-    QString direction;
+    InputSampler::Direction direction;
     switch (button) {
         case 0: // A button
-            emit modeTogglePressed();
+            if (pressed)
+                emit modeTogglePressed();
             return;
         case 1: // B button
-            direction = "UP";
+            direction = InputSampler::Up;
             break;
         case 2: // X button  
-            direction = "DOWN";
+            direction = InputSampler::Down;
             break;
         case 3: // Y button
-            direction = "LEFT";
+            direction = InputSampler::Left;
             break;
         case 4: // Left bumper
-            direction = "RIGHT";
+            direction = InputSampler::Right;
             break;
         default:
             return;
     }
     
-    // Send to server and emit local signal
-    sendButtonPress(direction);
-    emit directionPressed(direction);
+    if (m_sampling) {
+        m_sampler->setDirection(InputSampler::GamepadButtons, direction, pressed);
+    } else if (pressed) {
+        // Send to server and emit local signal
+        QString name = QLatin1String(InputSampler::directionName(direction));
+        sendButtonPress(name);
+        emit directionPressed(name);
+        emit directionReleased(name);
+    }
 }
 
 void NativeController::onGamepadAxisChanged(int axis, double value)
 {
-    if (!m_gamepadEnabled || qAbs(value) < 0.5) return;
+    GUI_WATCHDOG_SCOPE("NativeController::onGamepadAxisChanged");
+
+    if (!m_gamepadEnabled) return;
+
+    if (m_sampling) {
+        // Sent as a continuous, deadbanded value with the next sample
+        if (axis == 0 || axis == 1)
+            m_sampler->setAxis(axis == 0 ? InputSampler::AxisX : InputSampler::AxisY, value);
+        return;
+    }
+
+    if (qAbs(value) < 0.5) return;
     
     QString direction;
     if (axis == 0) { // Left stick X
@@ -270,48 +393,104 @@ void NativeController::onGamepadAxisChanged(int axis, double value)
     // Send to server and emit local signal
     sendButtonPress(direction);
     emit directionPressed(direction);
+    emit directionReleased(direction);
 }
 
 void NativeController::onKeyboardShortcut()
 {
+    GUI_WATCHDOG_SCOPE("NativeController::onKeyboardShortcut");
+
     if (!m_keyboardEnabled) return;
     
     QShortcut *shortcut = qobject_cast<QShortcut*>(sender());
     if (!shortcut) return;
     
-    QString key = shortcut->key().toString();
-    
-    if (key == "Space") {
+    if (shortcut->key().toString() == "Space") {
         emit modeTogglePressed();
-    } else if (key == "Up" || key == "W") {
-        sendButtonPress("UP");
-        emit directionPressed("UP");
-    } else if (key == "Down" || key == "S") {
-        sendButtonPress("DOWN");
-        emit directionPressed("DOWN");
-    } else if (key == "Left" || key == "A") {
-        sendButtonPress("LEFT");
-        emit directionPressed("LEFT");
-    } else if (key == "Right" || key == "D") {
-        sendButtonPress("RIGHT");
-        emit directionPressed("RIGHT");
     }
 }
 
+bool NativeController::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::ApplicationDeactivate) {
+        // Releases that happen while unfocused never arrive
+        m_sampler->releaseAll();
+    } else if (event->type() == QEvent::KeyPress && static_cast<QKeyEvent*>(event)->key() == Qt::Key_X) {
+        // Emergency stop works even with keyboard control disabled
+        if (!static_cast<QKeyEvent*>(event)->isAutoRepeat())
+            sendEmergencyStop();
+        return true;
+    } else if (m_keyboardEnabled
+               && (event->type() == QEvent::KeyPress || event->type() == QEvent::KeyRelease)) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+        InputSampler::Source source = InputSampler::ArrowKeys;
+        InputSampler::Direction direction;
+        switch (keyEvent->key()) {
+        case Qt::Key_Up:
+            direction = InputSampler::Up;
+            break;
+        case Qt::Key_Down:
+            direction = InputSampler::Down;
+            break;
+        case Qt::Key_Left:
+            direction = InputSampler::Left;
+            break;
+        case Qt::Key_Right:
+            direction = InputSampler::Right;
+            break;
+        case Qt::Key_W:
+            source = InputSampler::WasdKeys;
+            direction = InputSampler::Up;
+            break;
+        case Qt::Key_S:
+            source = InputSampler::WasdKeys;
+            direction = InputSampler::Down;
+            break;
+        case Qt::Key_A:
+            source = InputSampler::WasdKeys;
+            direction = InputSampler::Left;
+            break;
+        case Qt::Key_D:
+            source = InputSampler::WasdKeys;
+            direction = InputSampler::Right;
+            break;
+        default:
+            return QObject::eventFilter(watched, event);
+        }
+
+        GUI_WATCHDOG_SCOPE("NativeController::eventFilter");
+
+        bool pressed = event->type() == QEvent::KeyPress;
+        if (m_sampling) {
+            // Auto-repeat doesn't change what is held
+            if (!keyEvent->isAutoRepeat())
+                m_sampler->setDirection(source, direction, pressed);
+        } else if (pressed) {
+            // One command per key event, auto-repeat included
+            QString name = QLatin1String(InputSampler::directionName(direction));
+            sendButtonPress(name);
+            emit directionPressed(name);
+            emit directionReleased(name);
+        }
+        return true;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
 void NativeController::setupKeyboardShortcuts(QWidget *parent)
 {
     // Clear existing shortcuts
     qDeleteAll(m_shortcuts);
     m_shortcuts.clear();
     
-    // Define shortcuts
-    QStringList keys = {"Space", "Up", "Down", "Left", "Right", "W", "A", "S", "D"};
-    
-    for (const QString &key : keys) {
-        QShortcut *shortcut = new QShortcut(QKeySequence(key), parent);
-        connect(shortcut, &QShortcut::activated, this, &NativeController::onKeyboardShortcut);
-        m_shortcuts.append(shortcut);
-    }
+    // Space toggles the mode. Direction keys need their releases as well,
+    // which QShortcut doesn't report, so they go through eventFilter().
+    QShortcut *shortcut = new QShortcut(QKeySequence("Space"), parent);
+    connect(shortcut, &QShortcut::activated, this, &NativeController::onKeyboardShortcut);
+    m_shortcuts.append(shortcut);
+
+    qApp->removeEventFilter(this);
+    qApp->installEventFilter(this);
 }
 
 void NativeController::setupGamepad()
@@ -326,19 +505,22 @@ void NativeController::setupGamepad()
         connect(m_gamepad, &QGamepad::connected, this, &NativeController::onGamepadConnected);
         connect(m_gamepad, &QGamepad::disconnected, this, &NativeController::onGamepadDisconnected);
         connect(m_gamepad, &QGamepad::buttonAChanged, this, [this](bool pressed) {
-            if (pressed) onGamepadButtonPressed(0);
+            onGamepadButtonChanged(0, pressed);
         });
         connect(m_gamepad, &QGamepad::buttonBChanged, this, [this](bool pressed) {
-            if (pressed) onGamepadButtonPressed(1);
+            onGamepadButtonChanged(1, pressed);
         });
         connect(m_gamepad, &QGamepad::buttonXChanged, this, [this](bool pressed) {
-            if (pressed) onGamepadButtonPressed(2);
+            onGamepadButtonChanged(2, pressed);
         });
         connect(m_gamepad, &QGamepad::buttonYChanged, this, [this](bool pressed) {
-            if (pressed) onGamepadButtonPressed(3);
+            onGamepadButtonChanged(3, pressed);
         });
         connect(m_gamepad, &QGamepad::buttonL1Changed, this, [this](bool pressed) {
-            if (pressed) onGamepadButtonPressed(4);
+            onGamepadButtonChanged(4, pressed);
+        });
+        connect(m_gamepad, &QGamepad::buttonStartChanged, this, [this](bool pressed) {
+            onGamepadButtonChanged(5, pressed);
         });
         
         // Connect axis changes
@@ -350,62 +532,48 @@ void NativeController::setupGamepad()
         });
         
         m_gamepad->setEnabled(m_gamepadEnabled);
-        qDebug() << "Gamepad initialized successfully";
+        qCDebug(controller) << "Gamepad initialized successfully";
     } else {
-        qDebug() << "No gamepads found";
+        qCDebug(controller) << "No gamepads found";
     }
 #else
-    qDebug() << "Gamepad support not available - compiled without Qt Gamepad";
+    qCDebug(controller) << "Gamepad support not available - compiled without Qt Gamepad";
 #endif
 }
 
-void NativeController::sendUdpCommand(const QString &command)
+const LatencyHistogram &NativeController::roundTripTime() const
 {
-    if (!m_udpSocket || m_serverAddress.isEmpty()) {
-        qDebug() << "Cannot send UDP command: socket not ready or no server address";
-        return;
-    }
-    
-    QByteArray data = command.toUtf8();
-    qint64 bytesWritten = m_udpSocket->writeDatagram(data, QHostAddress(m_serverAddress), m_udpPort);
-    
-    if (bytesWritten == -1) {
-        qDebug() << "Failed to send UDP command:" << m_udpSocket->errorString();
-    } else {
-        qDebug() << "UDP command sent:" << command << "to" << m_serverAddress << ":" << m_udpPort;
-    }
+    return m_link->roundTripTime();
 }
 
-void NativeController::sendTcpCommand(const QString &command)
+const LatencyHistogram &NativeController::inputToWire() const
 {
-    if (!m_tcpClient || m_tcpClient->state() != QTcpSocket::ConnectedState) {
-        qDebug() << "Cannot send TCP command: not connected to server";
-        return;
-    }
-    
-    QString formattedCommand = command + "\n";
-    QByteArray data = formattedCommand.toUtf8();
-    qint64 bytesWritten = m_tcpClient->write(data);
-    
-    if (bytesWritten == -1) {
-        qDebug() << "Failed to send TCP command:" << m_tcpClient->errorString();
-    } else {
-        qDebug() << "TCP command sent:" << command;
-    }
+    return m_link->inputToWire();
 }
 
-void NativeController::connectToServer()
+const RadarScan *NativeController::takeScan()
 {
-    if (m_serverAddress.isEmpty()) {
-        qDebug() << "Cannot connect: no server address set";
-        return;
-    }
-    
-    if (m_tcpClient->state() == QTcpSocket::ConnectedState) {
-        qDebug() << "Already connected to server";
-        return;
+    return m_link->takeScan();
+}
+
+ControllerStats NativeController::stats() const
+{
+    ControllerStats stats = m_stats;
+    m_link->fillStats(stats);
+    return stats;
+}
+
+void NativeController::connectNotify(const QMetaMethod &signal)
+{
+    // Commands are only spelled out as text while somebody listens
+    if (signal == QMetaMethod::fromSignal(&NativeController::commandSent))
+        m_link->setReportCommands(true);
+}
+
+void NativeController::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&NativeController::commandSent)
+        && !isSignalConnected(QMetaMethod::fromSignal(&NativeController::commandSent))) {
+        m_link->setReportCommands(false);
     }
-    
-    qDebug() << "Connecting to TCP server at" << m_serverAddress << ":" << m_tcpPort;
-    m_tcpClient->connectToHost(m_serverAddress, m_tcpPort);
-}
\ No newline at end of file
+}
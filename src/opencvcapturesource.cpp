@@ -0,0 +1,68 @@
+#include "opencvcapturesource.h"
+
+#ifdef OPENCV_ENABLED
+OpenCvCaptureSource::OpenCvCaptureSource(const QString &url)
+    : m_url(url)
+{
+}
+
+OpenCvCaptureSource::~OpenCvCaptureSource()
+{
+    close();
+}
+
+bool OpenCvCaptureSource::open()
+{
+    // Open the stream with basic settings
+    if (!m_capture.open(m_url.toStdString()))
+        return false;
+
+    // Basic buffer optimization for low latency
+    m_capture.set(cv::CAP_PROP_BUFFERSIZE, 1);
+
+    m_frameSize = QSize(static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                        static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    return true;
+}
+
+void OpenCvCaptureSource::close()
+{
+    m_capture.release();
+}
+
+bool OpenCvCaptureSource::grab()
+{
+    return m_capture.grab();
+}
+
+bool OpenCvCaptureSource::retrieve(CaptureFrame &frame)
+{
+    return retrieveFrom(m_capture, m_frame, m_converted, frame);
+}
+
+bool OpenCvCaptureSource::retrieveFrom(cv::VideoCapture &capture, cv::Mat &frame, cv::Mat &converted, CaptureFrame &out)
+{
+    if (!capture.retrieve(frame) || frame.empty())
+        return false;
+
+    const cv::Mat *mat = &frame;
+    if (frame.type() == CV_8UC4) {
+        cv::cvtColor(frame, converted, cv::COLOR_BGRA2BGR);
+        mat = &converted;
+    } else if (frame.type() != CV_8UC3 && frame.type() != CV_8UC1) {
+        return false;
+    }
+
+    out.data = mat->data;
+    out.width = mat->cols;
+    out.height = mat->rows;
+    out.stride = static_cast<int>(mat->step);
+    out.channels = mat->channels();
+    return true;
+}
+
+QSize OpenCvCaptureSource::frameSize() const
+{
+    return m_frameSize;
+}
+#endif // OPENCV_ENABLED
@@ -0,0 +1,34 @@
+#include "overlaybutton.h"
+#include <QStyleOptionButton>
+#include <QStylePainter>
+
+OverlayButton::OverlayButton(const QString &text, QWidget *parent)
+    : QPushButton(text, parent)
+{
+}
+
+void OverlayButton::setRotated180(bool rotated)
+{
+    if (m_rotated180 == rotated)
+        return;
+
+    m_rotated180 = rotated;
+    update();
+}
+
+void OverlayButton::paintEvent(QPaintEvent *event)
+{
+    if (!m_rotated180) {
+        QPushButton::paintEvent(event);
+        return;
+    }
+
+    // Same drawing as QPushButton, with the painter turned around the centre
+    QStylePainter painter(this);
+    painter.translate(width(), height());
+    painter.rotate(180);
+
+    QStyleOptionButton option;
+    initStyleOption(&option);
+    painter.drawControl(QStyle::CE_PushButton, option);
+}
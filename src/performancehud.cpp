@@ -0,0 +1,211 @@
+#include "performancehud.h"
+#include "guiwatchdog.h"
+#include "monotonicclock.h"
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QtMath>
+
+PerformanceHud::PerformanceHud(QWidget *parent) : QWidget(parent)
+{
+    m_font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    m_font.setPixelSize(13);
+
+    m_lines.resize(LineCount);
+    for (QStaticText &line : m_lines) {
+        line.setTextFormat(Qt::PlainText);
+        line.setPerformanceHint(QStaticText::AggressiveCaching);
+    }
+
+    // Opaque and click-through: never composited with the video, never
+    // steals touches from it
+    setAttribute(Qt::WA_OpaquePaintEvent, true);
+    setAttribute(Qt::WA_NoSystemBackground, true);
+    setAttribute(Qt::WA_TransparentForMouseEvents, true);
+    setFocusPolicy(Qt::NoFocus);
+
+    m_refreshTimer.setInterval(RefreshMs);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &PerformanceHud::refresh);
+
+    updateGeometryForFont();
+}
+
+void PerformanceHud::setStreamer(RTSPStreamer *streamer)
+{
+    m_streamer = streamer;
+}
+
+void PerformanceHud::setController(NativeController *controller)
+{
+    m_controller = controller;
+}
+
+void PerformanceHud::setDisplayTransform(bool rotate180, qreal scale)
+{
+    m_rotated180 = rotate180;
+    m_scale = scale > 0 ? scale : 1.0;
+    updateGeometryForFont();
+
+    // Cached layouts are only valid for the transform they were prepared for
+    for (QStaticText &line : m_lines)
+        line.prepare(textTransform(), m_font);
+    update();
+}
+
+void PerformanceHud::framePainted(quint64 sequence, const FrameTimestamps &timestamps)
+{
+    Q_UNUSED(sequence);
+    m_lastPaintedNs = timestamps.painted;
+}
+
+void PerformanceHud::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    // Start from a fresh sample; the immediate refresh below shows the
+    // latencies, the rates follow with the first timer tick
+    m_sampleNs = MonotonicClock::timestampNs();
+    if (m_streamer)
+        m_stats = m_streamer->stats();
+    if (m_controller)
+        m_controllerStats = m_controller->stats();
+    m_usage = ProcessUsage::current();
+
+    refresh();
+    m_refreshTimer.start();
+}
+
+void PerformanceHud::hideEvent(QHideEvent *event)
+{
+    // Costs nothing while hidden
+    m_refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+void PerformanceHud::refresh()
+{
+    GUI_WATCHDOG_SCOPE("PerformanceHud::refresh");
+
+    qint64 now = MonotonicClock::timestampNs();
+    double seconds = qMax<qint64>(1, now - m_sampleNs) / 1e9;
+    // Rates over a fraction of an interval (right after showing) would be
+    // mostly noise: shown as "--" and the baseline kept until a full one
+    bool rates = now - m_sampleNs >= RefreshMs * 1000000LL / 2;
+    if (rates)
+        m_sampleNs = now;
+
+    if (m_streamer) {
+        StreamStats stats = m_streamer->stats();
+        double decodeFps = (stats.framesRetrieved - m_stats.framesRetrieved) / seconds;
+        double displayFps = (stats.framesDisplayed - m_stats.framesDisplayed) / seconds;
+        double droppedPercent = stats.framesGrabbed ? 100.0 * stats.framesDropped / stats.framesGrabbed : 0.0;
+        if (rates)
+            m_stats = stats;
+
+        LatencyHistogram::Summary total = m_streamer->latency().histogram(PipelineLatency::Total).summary();
+        QString age = m_lastPaintedNs ? QString::number((now - m_lastPaintedNs) / 1000000) : QString("--");
+
+        setLine(FpsLine, QString("fps     dec %1  disp %2")
+                             .arg(rateText(decodeFps, rates, 5, 1))
+                             .arg(rateText(displayFps, rates, 5, 1)));
+        setLine(FrameAgeLine, QString("frame   age %1ms  e2e %2/%3")
+                                  .arg(age, 4)
+                                  .arg(total.p50 / 1e6, 0, 'f', 1)
+                                  .arg(total.p99 / 1e6, 0, 'f', 1));
+        setLine(DecodeLine, stageText("decode", PipelineLatency::Decode));
+        setLine(ConvertLine, stageText("convert", PipelineLatency::Convert));
+        setLine(DeliverLine, stageText("deliver", PipelineLatency::Deliver));
+        setLine(PaintLine, stageText("paint", PipelineLatency::Paint));
+        setLine(DroppedLine, QString("dropped %1 (%2%)").arg(stats.framesDropped).arg(droppedPercent, 0, 'f', 1));
+    }
+
+    if (m_controller) {
+        ControllerStats stats = m_controller->stats();
+        quint64 commands = (stats.buttonCommands + stats.touchCommands + stats.modeCommands + stats.stateCommands)
+                         - (m_controllerStats.buttonCommands + m_controllerStats.touchCommands
+                            + m_controllerStats.modeCommands + m_controllerStats.stateCommands);
+        if (rates)
+            m_controllerStats = stats;
+        QString rtt = stats.smoothedRttNs > 0 ? QString::number(stats.smoothedRttNs / 1e6, 'f', 1) : QString("--");
+        setLine(CommandsLine, QString("cmds    %1/s  rtt %2ms  loss %3%")
+                                  .arg(rateText(commands / seconds, rates, 0, 1))
+                                  .arg(rtt)
+                                  .arg(100.0 * stats.lossRate, 0, 'f', 0));
+    }
+
+    ProcessUsage usage = ProcessUsage::current();
+    double cpuPercent = 100.0 * (usage.cpuSeconds - m_usage.cpuSeconds) / seconds;
+    if (rates)
+        m_usage = usage;
+    setLine(CpuLine, QString("cpu     %1%  rss %2MB")
+                         .arg(rateText(cpuPercent, rates, 0, 0))
+                         .arg(usage.residentBytes / (1024 * 1024)));
+}
+
+QString PerformanceHud::rateText(double value, bool valid, int width, int precision)
+{
+    return valid ? QString("%1").arg(value, width, 'f', precision) : QString("%1").arg("--", width);
+}
+
+QString PerformanceHud::stageText(const char *label, PipelineLatency::Stage stage) const
+{
+    LatencyHistogram::Summary s = m_streamer->latency().histogram(stage).summary();
+    return QString("%1 p50 %2 p99 %3ms")
+        .arg(QString::fromLatin1(label), -7)
+        .arg(s.p50 / 1e6, 5, 'f', 2)
+        .arg(s.p99 / 1e6, 5, 'f', 2);
+}
+
+void PerformanceHud::setLine(Line line, const QString &text)
+{
+    // Identical text keeps its cached layout and doesn't trigger a repaint
+    if (m_lines[line].text() == text)
+        return;
+
+    m_lines[line].setText(text);
+    m_lines[line].prepare(textTransform(), m_font);
+    update();
+}
+
+QTransform PerformanceHud::textTransform() const
+{
+    // Same rotation and scale as paintEvent(), without the translation
+    QTransform transform;
+    if (m_rotated180)
+        transform.rotate(180);
+    transform.scale(m_scale, m_scale);
+    return transform;
+}
+
+void PerformanceHud::updateGeometryForFont()
+{
+    QFontMetrics metrics(m_font);
+    m_lineHeight = metrics.height();
+    int padding = metrics.averageCharWidth();
+    QSize logical(metrics.averageCharWidth() * LineChars + 2 * padding,
+                  m_lineHeight * LineCount + 2 * padding);
+    setFixedSize(qCeil(logical.width() * m_scale), qCeil(logical.height() * m_scale));
+}
+
+void PerformanceHud::paintEvent(QPaintEvent *event)
+{
+    GUI_WATCHDOG_SCOPE("PerformanceHud::paintEvent");
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+
+    // Lines are laid out upright at scale 1, then mapped to the display
+    if (m_rotated180) {
+        painter.translate(width(), height());
+        painter.rotate(180);
+    }
+    painter.scale(m_scale, m_scale);
+
+    painter.fillRect(QRectF(0, 0, width() / m_scale, height() / m_scale), QColor(16, 16, 16));
+    painter.setFont(m_font);
+    painter.setPen(QColor(0, 255, 128));
+
+    int padding = QFontMetrics(m_font).averageCharWidth();
+    for (int i = 0; i < LineCount; ++i)
+        painter.drawStaticText(QPointF(padding, padding + i * m_lineHeight), m_lines[i]);
+}
@@ -0,0 +1,68 @@
+#include "pipelinelatency.h"
+
+void PipelineLatency::recordCaptured(const FrameTimestamps &timestamps)
+{
+    record(Decode, timestamps.grabbed, timestamps.decoded);
+    record(Convert, timestamps.decoded, timestamps.converted);
+    record(Publish, timestamps.converted, timestamps.published);
+}
+
+void PipelineLatency::recordPainted(const FrameTimestamps &timestamps)
+{
+    record(Deliver, timestamps.published, timestamps.received);
+    record(Present, timestamps.received, timestamps.presented);
+    record(Paint, timestamps.presented, timestamps.painted);
+    record(Total, timestamps.grabbed, timestamps.painted);
+}
+
+void PipelineLatency::reset()
+{
+    for (LatencyHistogram &histogram : m_histograms)
+        histogram.reset();
+}
+
+const char *PipelineLatency::stageName(Stage stage)
+{
+    switch (stage) {
+    case Decode:
+        return "decode";
+    case Convert:
+        return "convert";
+    case Publish:
+        return "publish";
+    case Deliver:
+        return "deliver";
+    case Present:
+        return "present";
+    case Paint:
+        return "paint";
+    case Total:
+        return "total";
+    case StageCount:
+        break;
+    }
+    return "unknown";
+}
+
+QString PipelineLatency::report() const
+{
+    auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 3); };
+
+    QString text;
+    for (int i = 0; i < StageCount; ++i) {
+        Stage stage = static_cast<Stage>(i);
+        LatencyHistogram::Summary s = m_histograms[i].summary();
+        text += QString("%1 count=%2 mean=%3 p50=%4 p99=%5 p999=%6 max=%7 ms\n")
+                    .arg(stageName(stage), -8)
+                    .arg(s.count)
+                    .arg(ms(s.mean), ms(s.p50), ms(s.p99), ms(s.p999), ms(s.max));
+    }
+    return text;
+}
+
+void PipelineLatency::record(Stage stage, qint64 from, qint64 to)
+{
+    // Skip stages a frame never went through
+    if (from > 0 && to > 0)
+        m_histograms[stage].record(to - from);
+}
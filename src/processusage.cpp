@@ -0,0 +1,34 @@
+#include "processusage.h"
+#include <QFile>
+#include <QList>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+ProcessUsage ProcessUsage::current()
+{
+    ProcessUsage usage;
+#ifdef Q_OS_UNIX
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.cpuSeconds = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+                         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#ifdef Q_OS_MACOS
+        usage.peakResidentBytes = ru.ru_maxrss;          // Bytes on macOS
+#else
+        usage.peakResidentBytes = ru.ru_maxrss * 1024LL; // Kilobytes on Linux
+#endif
+    }
+
+    // Current resident set size; statm reports pages
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            usage.residentBytes = fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return usage;
+}
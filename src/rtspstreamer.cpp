@@ -1,13 +1,12 @@
 #include "rtspstreamer.h"
+#include "displaymapping.h"
+#include "monotonicclock.h"
+#include <QDebug>
 
-RTSPStreamer::RTSPStreamer(QObject *parent) : QThread(parent), m_stopped(false), m_lowLatencyMode(true), m_streamSize(0, 0)
+RTSPStreamer::RTSPStreamer(QObject *parent) : QThread(parent), m_frameNotifyPending(false), m_stopped(false), m_lowLatencyMode(true), m_streamSize(0, 0), m_displayTransform(0),
+    m_consumerReady(true), m_framesGrabbed(0), m_framesRetrieved(0), m_framesConverted(0), m_framesDisplayed(0), m_framesDropped(0),
+    m_reconnects(0), m_timeToFirstFrameNs(0)
 {
-#ifdef OPENCV_ENABLED
-    m_opencvEnabled = true;
-#else
-    m_opencvEnabled = false;
-#endif
-    
     // Set thread priority for better performance
     setPriority(QThread::HighPriority);
 }
@@ -39,11 +38,16 @@ bool RTSPStreamer::isStreaming() const
 
 QImage RTSPStreamer::getCurrentFrame() const
 {
-    // Use direct mutex lock/unlock instead of QMutexLocker for const methods
-    m_mutex.lock();
-    QImage frame = m_currentFrame;
-    m_mutex.unlock();
-    return frame;
+    return currentFrame().image;
+}
+
+VideoFrame RTSPStreamer::currentFrame() const
+{
+    // Re-arm the notification before taking the slot so a frame published
+    // right after this point triggers a new frameReady()
+    m_frameNotifyPending.store(false, std::memory_order_release);
+    m_frames.update();
+    return m_frames.readSlot();
 }
 
 void RTSPStreamer::setLowLatencyMode(bool enabled)
@@ -71,6 +75,48 @@ int RTSPStreamer::getStreamHeight() const
     return getStreamSize().height();
 }
 
+void RTSPStreamer::setDisplayTransform(const QSize &size, bool rotate180)
+{
+    // Packed into one word so the capture thread reads a consistent
+    // size/rotation pair without taking a lock: width | height | rotation bit
+    quint64 width = static_cast<quint64>(qBound(0, size.width(), 0x7FFFFFFF));
+    quint64 height = static_cast<quint64>(qBound(0, size.height(), 0x7FFFFFFF));
+    m_displayTransform.store((width << 32) | (height << 1) | (rotate180 ? 1 : 0),
+                             std::memory_order_relaxed);
+}
+
+FramePool &RTSPStreamer::framePool()
+{
+    return m_framePool;
+}
+
+void RTSPStreamer::acknowledgeFrame(bool displayed)
+{
+    if (displayed)
+        m_framesDisplayed.fetch_add(1, std::memory_order_relaxed);
+    else
+        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+    m_consumerReady.store(true, std::memory_order_release);
+}
+
+StreamStats RTSPStreamer::stats() const
+{
+    StreamStats stats;
+    stats.framesGrabbed = m_framesGrabbed.load(std::memory_order_relaxed);
+    stats.framesRetrieved = m_framesRetrieved.load(std::memory_order_relaxed);
+    stats.framesConverted = m_framesConverted.load(std::memory_order_relaxed);
+    stats.framesDisplayed = m_framesDisplayed.load(std::memory_order_relaxed);
+    stats.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+    stats.reconnects = m_reconnects.load(std::memory_order_relaxed);
+    stats.timeToFirstFrameNs = m_timeToFirstFrameNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+PipelineLatency &RTSPStreamer::latency()
+{
+    return m_latency;
+}
+
 void RTSPStreamer::run()
 {
     m_mutex.lock();
@@ -78,87 +124,120 @@ void RTSPStreamer::run()
     QString rtspUrl = m_rtspUrl;
     m_mutex.unlock();
 
-    if (!m_opencvEnabled) {
-        emit connectionFailed();
-        return;
-    }
-
-#ifdef OPENCV_ENABLED
-    // Open the RTSP stream with basic settings
-    m_videoCapture.open(rtspUrl.toStdString());
+    // A new run after a failed one is a reconnect as well
+    if (m_hasRun)
+        m_reconnects.fetch_add(1, std::memory_order_relaxed);
+    m_hasRun = true;
+    qint64 connectStartNs = MonotonicClock::timestampNs();
+    bool firstFrame = true;
 
-    // Check if the stream is opened successfully
-    if (!m_videoCapture.isOpened()) {
+    // Pick the capture backend from the URL scheme
+    std::unique_ptr<CaptureSource> source = CaptureSource::create(rtspUrl);
+    if (!source || !source->open()) {
         emit connectionFailed();
         return;
     }
 
-    // Basic buffer optimization for low latency
-    m_videoCapture.set(cv::CAP_PROP_BUFFERSIZE, 1);
-
-    // Get stream dimensions and store them
-    int width = static_cast<int>(m_videoCapture.get(cv::CAP_PROP_FRAME_WIDTH));
-    int height = static_cast<int>(m_videoCapture.get(cv::CAP_PROP_FRAME_HEIGHT));
-    
     m_mutex.lock();
-    m_streamSize = QSize(width, height);
+    m_streamSize = source->frameSize();
     m_mutex.unlock();
 
-    // Main capture loop
+    CaptureFrame frame;
+    QElapsedTimer sincePublish;
+    sincePublish.start();
+    m_consumerReady.store(true, std::memory_order_relaxed);
+    bool grabbedSinceOpen = false;
+
     while (!m_stopped) {
-        cv::Mat frame;
-        if (!m_videoCapture.read(frame)) {
-            // If we couldn't read the frame, try to reconnect
-            m_videoCapture.release();
-            if (!m_videoCapture.open(rtspUrl.toStdString())) {
+        // Always grab so the network/decoder buffers never back up
+        if (!source->grab()) {
+            // A source that opens but never yields a frame (truncated
+            // recording, undecodable video) would reopen in a busy loop:
+            // report it and let the GUI retry later
+            if (!grabbedSinceOpen) {
                 emit connectionFailed();
                 break;
             }
+
+            // If we couldn't grab the frame, try to reconnect
+            grabbedSinceOpen = false;
+            source->close();
+            m_reconnects.fetch_add(1, std::memory_order_relaxed);
+            connectStartNs = MonotonicClock::timestampNs();
+            firstFrame = true;
+            if (!source->open()) {
+                emit connectionFailed();
+                break;
+            }
+            continue;
+        }
+        grabbedSinceOpen = true;
+        FrameTimestamps timestamps;
+        timestamps.grabbed = MonotonicClock::timestampNs();
+        quint64 sequence = m_framesGrabbed.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        // The GUI hasn't dealt with the previous frame yet, so this one would
+        // never be shown: skip retrieving and converting it. The timeout
+        // keeps the stream going should an acknowledgement ever get lost.
+        if (!m_consumerReady.load(std::memory_order_acquire)
+            && sincePublish.elapsed() < ConsumerTimeoutMs) {
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
             continue;
         }
 
-        if (frame.empty())
+        if (!source->retrieve(frame) || frame.isNull()) {
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
             continue;
+        }
+        timestamps.decoded = MonotonicClock::timestampNs();
+        m_framesRetrieved.fetch_add(1, std::memory_order_relaxed);
 
         // Convert the frame to QImage
-        QImage qimg = matToQImage(frame);
+        QImage qimg = frameToQImage(frame);
+        if (qimg.isNull()) {
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        timestamps.converted = MonotonicClock::timestampNs();
+        m_framesConverted.fetch_add(1, std::memory_order_relaxed);
+
+        // Hand the frame over to the GUI; an unread older frame is simply replaced
+        m_consumerReady.store(false, std::memory_order_relaxed);
+        timestamps.published = MonotonicClock::timestampNs();
+        VideoFrame &slot = m_frames.writeSlot();
+        slot.image = qimg;
+        slot.sequence = sequence;
+        slot.timestamps = timestamps;
+        if (m_frames.publish())
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed); // Never picked up by the GUI
+        sincePublish.restart();
+
+        if (firstFrame) {
+            firstFrame = false;
+            m_timeToFirstFrameNs.store(timestamps.published - connectStartNs, std::memory_order_relaxed);
+        }
 
-        m_mutex.lock();
-        m_currentFrame = qimg;
-        m_mutex.unlock();
+        // Only notify if the GUI hasn't got a notification pending already
+        if (!m_frameNotifyPending.exchange(true, std::memory_order_acq_rel))
+            emit frameReady();
+        m_latency.recordCaptured(timestamps);
+    }
 
-        // Emit signal with the new frame
-        emit newFrameAvailable(qimg);
+    // Close the capture source when done
+    source->close();
 
-        // Minimal delay for low latency - let OpenCV handle timing
-        msleep(1);
-    }
+    StreamStats counters = stats();
+    qDebug() << "Stream stats - grabbed:" << counters.framesGrabbed
+             << "retrieved:" << counters.framesRetrieved
+             << "converted:" << counters.framesConverted
+             << "displayed:" << counters.framesDisplayed;
+    qDebug() << "Frame pool stats - hits:" << m_framePool.hits() << "misses:" << m_framePool.misses();
+}
 
-    // Close the video capture when done
-    m_videoCapture.release();
-#endif
-}
-
-#ifdef OPENCV_ENABLED
-QImage RTSPStreamer::matToQImage(const cv::Mat &mat) const
-{
-    // Handle different image formats
-    if (mat.type() == CV_8UC3) {
-        // Convert BGR to RGB
-        cv::Mat rgbMat;
-        cv::cvtColor(mat, rgbMat, cv::COLOR_BGR2RGB);
-        return QImage(rgbMat.data, rgbMat.cols, rgbMat.rows, 
-                      rgbMat.step, QImage::Format_RGB888).copy();
-    } else if (mat.type() == CV_8UC1) {
-        // Grayscale image
-        return QImage(mat.data, mat.cols, mat.rows, 
-                      mat.step, QImage::Format_Grayscale8).copy();
-    } else {
-        // Default case - convert to RGB
-        cv::Mat rgbMat;
-        cv::cvtColor(mat, rgbMat, cv::COLOR_BGR2RGB);
-        return QImage(rgbMat.data, rgbMat.cols, rgbMat.rows, 
-                      rgbMat.step, QImage::Format_RGB888).copy();
-    }
+QImage RTSPStreamer::frameToQImage(const CaptureFrame &frame)
+{
+    quint64 transform = m_displayTransform.load(std::memory_order_relaxed);
+    QSize size(static_cast<int>(transform >> 32), static_cast<int>((transform >> 1) & 0x7FFFFFFF));
+    bool rotate180 = (transform & 1) != 0;
+    return ::frameToQImage(frame, size, rotate180, m_framePool);
 }
-#endif
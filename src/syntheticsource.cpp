@@ -0,0 +1,214 @@
+#include "syntheticsource.h"
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+const int MarkerSize = 64;
+const int NoiseExtraRows = 64; // Noise frames scroll through a taller buffer
+}
+
+SyntheticSource::SyntheticSource(const QString &url)
+{
+    static const QRegularExpression pattern(
+        "^synthetic://(\\d+)x(\\d+)(?:@(\\d+(?:\\.\\d+)?))?(?:/(\\w+))?/?(?:\\?(\\w+))?$",
+        QRegularExpression::CaseInsensitiveOption);
+
+    QRegularExpressionMatch match = pattern.match(url);
+    if (!match.hasMatch()) {
+        qWarning() << "Invalid synthetic source URL:" << url;
+        return;
+    }
+
+    m_size = QSize(match.captured(1).toInt(), match.captured(2).toInt());
+    if (!match.captured(3).isEmpty())
+        m_fps = match.captured(3).toDouble();
+
+    QString patternName = match.captured(4).toLower();
+    if (patternName.isEmpty() || patternName == "bars") {
+        m_pattern = Bars;
+    } else if (patternName == "gradient") {
+        m_pattern = Gradient;
+    } else if (patternName == "noise") {
+        m_pattern = Noise;
+    } else {
+        qWarning() << "Unknown synthetic pattern:" << patternName;
+        return;
+    }
+
+    if (match.captured(5).compare("gray", Qt::CaseInsensitive) == 0)
+        m_channels = 1;
+
+    m_valid = !m_size.isEmpty();
+}
+
+bool SyntheticSource::open()
+{
+    if (!m_valid)
+        return false;
+
+    renderBackground();
+    m_frame = m_background;
+    m_markerPos = QPoint(-1, -1);
+    m_frameIndex = 0;
+    m_nextFrameNs = 0;
+    m_clock.start();
+
+    qDebug() << "Synthetic source:" << m_size << "@" << m_fps << "fps, channels:" << m_channels;
+    return true;
+}
+
+void SyntheticSource::close()
+{
+    m_background.clear();
+    m_background.shrink_to_fit();
+    m_frame.clear();
+    m_frame.shrink_to_fit();
+}
+
+bool SyntheticSource::grab()
+{
+    if (m_background.empty())
+        return false;
+
+    // Pace frames like a camera would
+    if (m_fps > 0) {
+        const qint64 periodNs = static_cast<qint64>(1e9 / m_fps);
+        qint64 now = m_clock.nsecsElapsed();
+        if (m_nextFrameNs > now) {
+            QThread::usleep(static_cast<unsigned long>((m_nextFrameNs - now) / 1000));
+        } else if (now - m_nextFrameNs > periodNs) {
+            // Fell behind (e.g. stalled consumer): don't try to catch up with a burst
+            m_nextFrameNs = now;
+        }
+        m_nextFrameNs += periodNs;
+    }
+
+    ++m_frameIndex;
+    return true;
+}
+
+bool SyntheticSource::retrieve(CaptureFrame &frame)
+{
+    if (m_background.empty())
+        return false;
+
+    frame.width = m_size.width();
+    frame.height = m_size.height();
+    frame.stride = stride();
+    frame.channels = m_channels;
+
+    if (m_pattern == Noise) {
+        // Scroll through the noise buffer; no pixels are written per frame
+        int offsetRow = static_cast<int>(m_frameIndex % NoiseExtraRows);
+        frame.data = m_background.data() + static_cast<size_t>(offsetRow) * stride();
+        return true;
+    }
+
+    moveMarker();
+    frame.data = m_frame.data();
+    return true;
+}
+
+QSize SyntheticSource::frameSize() const
+{
+    return m_valid ? m_size : QSize();
+}
+
+void SyntheticSource::renderBackground()
+{
+    const int width = m_size.width();
+    const int height = m_size.height();
+    const int rows = m_pattern == Noise ? height + NoiseExtraRows : height;
+    m_background.assign(static_cast<size_t>(rows) * stride(), 0);
+
+    if (m_pattern == Noise) {
+        QRandomGenerator *random = QRandomGenerator::global();
+        for (size_t i = 0; i < m_background.size(); ++i)
+            m_background[i] = static_cast<uchar>(random->bounded(256));
+        return;
+    }
+
+    if (m_pattern == Bars) {
+        // Classic colour bars (BGR): white, yellow, cyan, green, magenta, red, blue, black
+        static const uchar bars[8][3] = {
+            {235, 235, 235}, {16, 235, 235}, {235, 235, 16}, {16, 235, 16},
+            {235, 16, 235}, {16, 16, 235}, {235, 16, 16}, {16, 16, 16}
+        };
+        for (int i = 0; i < 8; ++i) {
+            int x0 = width * i / 8;
+            int x1 = width * (i + 1) / 8;
+            fillRect(m_background, x0, 0, x1 - x0, height, bars[i]);
+        }
+        return;
+    }
+
+    // Gradient: blue rises left to right, green top to bottom, red diagonally
+    for (int y = 0; y < height; ++y) {
+        uchar *row = m_background.data() + static_cast<size_t>(y) * stride();
+        for (int x = 0; x < width; ++x) {
+            uchar b = static_cast<uchar>(x * 255 / std::max(1, width - 1));
+            uchar g = static_cast<uchar>(y * 255 / std::max(1, height - 1));
+            uchar r = static_cast<uchar>((b + g) / 2);
+            if (m_channels == 3) {
+                row[3 * x] = b;
+                row[3 * x + 1] = g;
+                row[3 * x + 2] = r;
+            } else {
+                row[x] = r;
+            }
+        }
+    }
+}
+
+void SyntheticSource::moveMarker()
+{
+    // A white square bouncing across the frame so consecutive frames differ
+    const int markerW = std::min(MarkerSize, m_size.width());
+    const int markerH = std::min(MarkerSize, m_size.height());
+    const int rangeX = m_size.width() - markerW;
+    const int rangeY = m_size.height() - markerH;
+
+    if (m_markerPos.x() >= 0)
+        copyRect(m_markerPos.x(), m_markerPos.y(), markerW, markerH);
+
+    auto bounce = [](quint64 step, int range) {
+        if (range <= 0)
+            return 0;
+        int phase = static_cast<int>(step % (2 * static_cast<quint64>(range)));
+        return phase < range ? phase : 2 * range - phase;
+    };
+    m_markerPos = QPoint(bounce(m_frameIndex * 8, rangeX), bounce(m_frameIndex * 5, rangeY));
+
+    static const uchar white[3] = {255, 255, 255};
+    fillRect(m_frame, m_markerPos.x(), m_markerPos.y(), markerW, markerH, white);
+}
+
+void SyntheticSource::fillRect(std::vector<uchar> &buffer, int x, int y, int w, int h, const uchar *bgr)
+{
+    for (int row = y; row < y + h; ++row) {
+        uchar *p = buffer.data() + static_cast<size_t>(row) * stride() + x * m_channels;
+        for (int col = 0; col < w; ++col) {
+            if (m_channels == 3) {
+                p[0] = bgr[0];
+                p[1] = bgr[1];
+                p[2] = bgr[2];
+                p += 3;
+            } else {
+                *p++ = static_cast<uchar>((bgr[0] + bgr[1] + bgr[2]) / 3);
+            }
+        }
+    }
+}
+
+void SyntheticSource::copyRect(int x, int y, int w, int h)
+{
+    // Restore part of the frame from the background
+    for (int row = y; row < y + h; ++row) {
+        size_t offset = static_cast<size_t>(row) * stride() + x * m_channels;
+        std::copy(m_background.begin() + offset, m_background.begin() + offset + w * m_channels,
+                  m_frame.begin() + offset);
+    }
+}
@@ -0,0 +1,351 @@
+#include "videokernel.h"
+#include <cstring>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define VIDEOKERNEL_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && (!defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define VIDEOKERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const uint32_t OpaqueAlpha = 0xFF000000u;
+
+// Nearest-neighbour source index for destination index d (sampling at pixel centres)
+inline int sourceIndex(int d, int srcLength, int dstLength)
+{
+    int s = static_cast<int>(((2 * static_cast<int64_t>(d) + 1) * srcLength) / (2 * static_cast<int64_t>(dstLength)));
+    return s < srcLength ? s : srcLength - 1;
+}
+
+inline uint32_t packBgr(const uint8_t *p)
+{
+    return OpaqueAlpha | (uint32_t(p[2]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[0]);
+}
+
+inline uint32_t packGray(uint8_t v)
+{
+    return OpaqueAlpha | (uint32_t(v) * 0x010101u);
+}
+
+inline uint32_t load32(const uint8_t *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Row kernels for the resampling case. 'offsets' holds the source byte offset
+// of every destination pixel (already mirrored when rotating). Inside
+// [begin, end) a 4-byte read at any offset stays within the source row.
+typedef void (*GatherRowFn)(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                            int count, int begin, int end, VideoKernel::SourceFormat format);
+
+// Row kernels for a 1:1 horizontal scale; 'reverse' mirrors the row
+typedef void (*CopyRowFn)(const uint8_t *row, uint32_t *out, int width, bool reverse,
+                          VideoKernel::SourceFormat format);
+
+void gatherRange(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                 int from, int to, VideoKernel::SourceFormat format)
+{
+    if (format == VideoKernel::Bgr24) {
+        for (int x = from; x < to; ++x)
+            out[x] = packBgr(row + offsets[x]);
+    } else {
+        for (int x = from; x < to; ++x)
+            out[x] = packGray(row[offsets[x]]);
+    }
+}
+
+void copyRange(const uint8_t *row, uint32_t *out, int width, bool reverse,
+               int from, VideoKernel::SourceFormat format)
+{
+    for (int x = from; x < width; ++x) {
+        int sx = reverse ? width - 1 - x : x;
+        out[x] = format == VideoKernel::Bgr24 ? packBgr(row + 3 * sx) : packGray(row[sx]);
+    }
+}
+
+void gatherRowScalar(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                     int count, int begin, int end, VideoKernel::SourceFormat format)
+{
+    (void)begin;
+    (void)end;
+    gatherRange(row, offsets, out, 0, count, format);
+}
+
+void copyRowScalar(const uint8_t *row, uint32_t *out, int width, bool reverse,
+                   VideoKernel::SourceFormat format)
+{
+    copyRange(row, out, width, reverse, 0, format);
+}
+
+#if defined(VIDEOKERNEL_X86)
+__attribute__((target("sse2")))
+void gatherRowSse2(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                   int count, int begin, int end, VideoKernel::SourceFormat format)
+{
+    gatherRange(row, offsets, out, 0, begin, format);
+
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(OpaqueAlpha));
+    int x = begin;
+    if (format == VideoKernel::Bgr24) {
+        for (; x + 4 <= end; x += 4) {
+            __m128i v = _mm_set_epi32(static_cast<int>(load32(row + offsets[x + 3])),
+                                      static_cast<int>(load32(row + offsets[x + 2])),
+                                      static_cast<int>(load32(row + offsets[x + 1])),
+                                      static_cast<int>(load32(row + offsets[x])));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(v, alpha));
+        }
+    } else {
+        for (; x + 4 <= end; x += 4) {
+            __m128i v = _mm_set_epi32(row[offsets[x + 3]], row[offsets[x + 2]],
+                                      row[offsets[x + 1]], row[offsets[x]]);
+            v = _mm_or_si128(v, _mm_slli_epi32(v, 8));
+            v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(v, alpha));
+        }
+    }
+
+    gatherRange(row, offsets, out, x, count, format);
+}
+
+__attribute__((target("avx2")))
+void gatherRowAvx2(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                   int count, int begin, int end, VideoKernel::SourceFormat format)
+{
+    gatherRange(row, offsets, out, 0, begin, format);
+
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OpaqueAlpha));
+    const int *base = reinterpret_cast<const int*>(row);
+    int x = begin;
+    if (format == VideoKernel::Bgr24) {
+        for (; x + 8 <= end; x += 8) {
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + x));
+            __m256i v = _mm256_i32gather_epi32(base, index, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_or_si256(v, alpha));
+        }
+    } else {
+        const __m256i lowByte = _mm256_set1_epi32(0xFF);
+        const __m256i spread = _mm256_set1_epi32(0x010101);
+        for (; x + 8 <= end; x += 8) {
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + x));
+            __m256i v = _mm256_and_si256(_mm256_i32gather_epi32(base, index, 1), lowByte);
+            v = _mm256_mullo_epi32(v, spread);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_or_si256(v, alpha));
+        }
+    }
+
+    gatherRange(row, offsets, out, x, count, format);
+}
+
+__attribute__((target("ssse3")))
+void copyRowSsse3(const uint8_t *row, uint32_t *out, int width, bool reverse,
+                  VideoKernel::SourceFormat format)
+{
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(OpaqueAlpha));
+    const char Z = static_cast<char>(0x80); // pshufb: zero the byte
+    int x = 0;
+
+    if (format == VideoKernel::Bgr24) {
+        const __m128i mask = reverse
+            ? _mm_setr_epi8(9, 10, 11, Z, 6, 7, 8, Z, 3, 4, 5, Z, 0, 1, 2, Z)
+            : _mm_setr_epi8(0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z);
+        for (; x + 4 <= width; x += 4) {
+            // Load exactly the 12 bytes of four pixels so the row end is never overrun
+            const uint8_t *p = row + 3 * (reverse ? width - 4 - x : x);
+            __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)),
+                                           _mm_cvtsi32_si128(static_cast<int>(load32(p + 8))));
+            v = _mm_shuffle_epi8(v, mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(v, alpha));
+        }
+    } else {
+        const __m128i mask = reverse
+            ? _mm_setr_epi8(3, 3, 3, Z, 2, 2, 2, Z, 1, 1, 1, Z, 0, 0, 0, Z)
+            : _mm_setr_epi8(0, 0, 0, Z, 1, 1, 1, Z, 2, 2, 2, Z, 3, 3, 3, Z);
+        for (; x + 4 <= width; x += 4) {
+            const uint8_t *p = row + (reverse ? width - 4 - x : x);
+            __m128i v = _mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(load32(p))), mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(v, alpha));
+        }
+    }
+
+    copyRange(row, out, width, reverse, x, format);
+}
+#endif // VIDEOKERNEL_X86
+
+#if defined(VIDEOKERNEL_NEON)
+inline uint8x16_t reverseBytes(uint8x16_t v)
+{
+    v = vrev64q_u8(v);
+    return vextq_u8(v, v, 8);
+}
+
+void gatherRowNeon(const uint8_t *row, const int32_t *offsets, uint32_t *out,
+                   int count, int begin, int end, VideoKernel::SourceFormat format)
+{
+    gatherRange(row, offsets, out, 0, begin, format);
+
+    const uint32x4_t alpha = vdupq_n_u32(OpaqueAlpha);
+    int x = begin;
+    if (format == VideoKernel::Bgr24) {
+        for (; x + 4 <= end; x += 4) {
+            const uint32_t lanes[4] = { load32(row + offsets[x]), load32(row + offsets[x + 1]),
+                                        load32(row + offsets[x + 2]), load32(row + offsets[x + 3]) };
+            vst1q_u32(out + x, vorrq_u32(vld1q_u32(lanes), alpha));
+        }
+    } else {
+        for (; x + 4 <= end; x += 4) {
+            const uint32_t lanes[4] = { row[offsets[x]], row[offsets[x + 1]],
+                                        row[offsets[x + 2]], row[offsets[x + 3]] };
+            uint32x4_t v = vmulq_n_u32(vld1q_u32(lanes), 0x010101u);
+            vst1q_u32(out + x, vorrq_u32(v, alpha));
+        }
+    }
+
+    gatherRange(row, offsets, out, x, count, format);
+}
+
+void copyRowNeon(const uint8_t *row, uint32_t *out, int width, bool reverse,
+                 VideoKernel::SourceFormat format)
+{
+    const uint8x16_t alpha = vdupq_n_u8(0xFF);
+    int x = 0;
+
+    if (format == VideoKernel::Bgr24) {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x3_t bgr = vld3q_u8(row + 3 * (reverse ? width - 16 - x : x));
+            uint8x16x4_t bgra;
+            bgra.val[0] = reverse ? reverseBytes(bgr.val[0]) : bgr.val[0];
+            bgra.val[1] = reverse ? reverseBytes(bgr.val[1]) : bgr.val[1];
+            bgra.val[2] = reverse ? reverseBytes(bgr.val[2]) : bgr.val[2];
+            bgra.val[3] = alpha;
+            vst4q_u8(reinterpret_cast<uint8_t*>(out + x), bgra);
+        }
+    } else {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16_t gray = vld1q_u8(row + (reverse ? width - 16 - x : x));
+            if (reverse)
+                gray = reverseBytes(gray);
+            uint8x16x4_t bgra;
+            bgra.val[0] = gray;
+            bgra.val[1] = gray;
+            bgra.val[2] = gray;
+            bgra.val[3] = alpha;
+            vst4q_u8(reinterpret_cast<uint8_t*>(out + x), bgra);
+        }
+    }
+
+    copyRange(row, out, width, reverse, x, format);
+}
+#endif // VIDEOKERNEL_NEON
+
+struct Backend {
+    const char *name;
+    GatherRowFn gatherRow;
+    CopyRowFn copyRow;
+};
+
+Backend selectBackend()
+{
+#if defined(VIDEOKERNEL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return { "avx2", gatherRowAvx2, copyRowSsse3 };
+    if (__builtin_cpu_supports("ssse3"))
+        return { "ssse3", gatherRowSse2, copyRowSsse3 };
+    if (__builtin_cpu_supports("sse2"))
+        return { "sse2", gatherRowSse2, copyRowScalar };
+    return { "scalar", gatherRowScalar, copyRowScalar };
+#elif defined(VIDEOKERNEL_NEON)
+    return { "neon", gatherRowNeon, copyRowNeon };
+#else
+    return { "scalar", gatherRowScalar, copyRowScalar };
+#endif
+}
+
+const Backend &backend()
+{
+    static const Backend selected = selectBackend();
+    return selected;
+}
+
+} // namespace
+
+void VideoKernel::convertScaleRotate(const Source &src, const Target &dst, bool rotate180)
+{
+    if (!src.data || !dst.data || src.width <= 0 || src.height <= 0
+        || dst.width <= 0 || dst.height <= 0) {
+        return;
+    }
+
+    const Backend &impl = backend();
+
+    if (src.width == dst.width) {
+        // No horizontal resampling: contiguous loads, optionally mirrored
+        for (int dy = 0; dy < dst.height; ++dy) {
+            int sy = sourceIndex(rotate180 ? dst.height - 1 - dy : dy, src.height, dst.height);
+            impl.copyRow(src.data + static_cast<size_t>(sy) * src.stride,
+                         reinterpret_cast<uint32_t*>(dst.data + static_cast<size_t>(dy) * dst.stride),
+                         dst.width, rotate180, src.format);
+        }
+        return;
+    }
+
+    // Source byte offset of every output column, shared by all rows. The
+    // table only ever grows, so steady-state frames don't allocate.
+    const int bytesPerPixel = src.format == Bgr24 ? 3 : 1;
+    thread_local std::vector<int32_t> offsets;
+    if (static_cast<int>(offsets.size()) < dst.width)
+        offsets.resize(dst.width);
+    for (int dx = 0; dx < dst.width; ++dx) {
+        int sx = sourceIndex(rotate180 ? dst.width - 1 - dx : dx, src.width, dst.width);
+        offsets[dx] = sx * bytesPerPixel;
+    }
+
+    // 4-byte vector loads must not read past the end of a source row. The
+    // table is monotonic, so the unsafe columns sit at one end of it.
+    const int32_t lastSafeOffset = src.width * bytesPerPixel - 4;
+    int begin = 0;
+    while (begin < dst.width && offsets[begin] > lastSafeOffset)
+        ++begin;
+    int end = dst.width;
+    while (end > begin && offsets[end - 1] > lastSafeOffset)
+        --end;
+
+    for (int dy = 0; dy < dst.height; ++dy) {
+        int sy = sourceIndex(rotate180 ? dst.height - 1 - dy : dy, src.height, dst.height);
+        impl.gatherRow(src.data + static_cast<size_t>(sy) * src.stride, offsets.data(),
+                       reinterpret_cast<uint32_t*>(dst.data + static_cast<size_t>(dy) * dst.stride),
+                       dst.width, begin, end, src.format);
+    }
+}
+
+void VideoKernel::convertScaleRotateReference(const Source &src, const Target &dst, bool rotate180)
+{
+    if (!src.data || !dst.data || src.width <= 0 || src.height <= 0
+        || dst.width <= 0 || dst.height <= 0) {
+        return;
+    }
+
+    const int bytesPerPixel = src.format == Bgr24 ? 3 : 1;
+    for (int dy = 0; dy < dst.height; ++dy) {
+        int sy = sourceIndex(rotate180 ? dst.height - 1 - dy : dy, src.height, dst.height);
+        const uint8_t *row = src.data + static_cast<size_t>(sy) * src.stride;
+        uint32_t *out = reinterpret_cast<uint32_t*>(dst.data + static_cast<size_t>(dy) * dst.stride);
+
+        for (int dx = 0; dx < dst.width; ++dx) {
+            int sx = sourceIndex(rotate180 ? dst.width - 1 - dx : dx, src.width, dst.width);
+            const uint8_t *p = row + sx * bytesPerPixel;
+            out[dx] = src.format == Bgr24 ? packBgr(p) : packGray(*p);
+        }
+    }
+}
+
+const char *VideoKernel::backendName()
+{
+    return backend().name;
+}
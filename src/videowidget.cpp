@@ -0,0 +1,126 @@
+#include "videowidget.h"
+#include "guiwatchdog.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QRegion>
+
+VideoWidget::VideoWidget(QWidget *parent) : QWidget(parent)
+{
+    // Every pixel is painted by paintEvent(), so skip the background erase
+    setAttribute(Qt::WA_OpaquePaintEvent, true);
+    setAttribute(Qt::WA_NoSystemBackground, true);
+}
+
+bool VideoWidget::setFrame(const QImage &frame)
+{
+    if (frame.isNull() || !isVisible() || frame.cacheKey() == m_frame.cacheKey()) {
+        // Not reported: the producer shouldn't send more while nothing can
+        // be shown, its timeout paces it instead
+        ++m_skippedFrames;
+        return false;
+    }
+
+    if (m_framePending) {
+        // The previous frame never made it to the screen
+        ++m_skippedFrames;
+        emit framePresented(false);
+    }
+
+    bool sizeChanged = frame.size() != m_frame.size();
+    bool hadMessage = !m_message.isEmpty();
+    m_frame = frame;
+    m_message.clear();
+    m_framePending = true;
+
+    if (sizeChanged || hadMessage) {
+        // Geometry changed: the letterbox bars need repainting as well
+        updateVideoRect();
+        update();
+    } else {
+        update(m_videoRect.intersected(rect()));
+    }
+    return true;
+}
+
+void VideoWidget::showMessage(const QString &message)
+{
+    m_frame = QImage();
+    m_message = message;
+    m_framePending = false;
+    update();
+}
+
+void VideoWidget::clear()
+{
+    showMessage(QString());
+}
+
+void VideoWidget::setRotated180(bool rotated)
+{
+    if (m_rotated180 == rotated)
+        return;
+
+    m_rotated180 = rotated;
+    update();
+}
+
+void VideoWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateVideoRect();
+}
+
+void VideoWidget::updateVideoRect()
+{
+    if (m_frame.isNull()) {
+        m_videoRect = QRect();
+        return;
+    }
+
+    // Fill the widget while keeping the aspect ratio, cropping the overflow
+    QSize scaledSize = m_frame.size().scaled(size(), Qt::KeepAspectRatioByExpanding);
+    m_videoRect = QRect(QPoint((width() - scaledSize.width()) / 2,
+                               (height() - scaledSize.height()) / 2),
+                        scaledSize);
+}
+
+void VideoWidget::paintEvent(QPaintEvent *event)
+{
+    GUI_WATCHDOG_SCOPE("VideoWidget::paintEvent");
+
+    QPainter painter(this);
+
+    if (m_frame.isNull()) {
+        painter.fillRect(rect(), Qt::black);
+        if (!m_message.isEmpty()) {
+            if (m_rotated180) {
+                painter.translate(width(), height());
+                painter.rotate(180);
+            }
+            painter.setPen(Qt::white);
+            painter.setFont(QFont("Arial", 16));
+            painter.drawText(rect(), Qt::AlignCenter, m_message);
+        }
+        return;
+    }
+
+    // Letterbox bars, only where the exposed area isn't covered by video
+    const QRegion bars = QRegion(event->rect()).subtracted(m_videoRect);
+    for (const QRect &bar : bars) {
+        painter.fillRect(bar, Qt::black);
+    }
+
+    if (m_videoRect.size() == m_frame.size()) {
+        // Frames normally arrive display-sized from the capture thread: plain blit
+        painter.drawImage(m_videoRect.topLeft(), m_frame);
+    } else {
+        // Fast (nearest) scaling while the capture thread catches up with a resize
+        painter.drawImage(m_videoRect, m_frame);
+    }
+
+    if (m_framePending) {
+        m_framePending = false;
+        ++m_paintedFrames;
+        emit framePresented(true);
+    }
+}
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+Decoder for Kria's binary control protocol (--control-protocol binary)
+
+Layout (big-endian), see include/controlprotocol.h:
+  magic u16 0x4B43 | version u8 | type u8 | sequence u32 |
+  send time u64 ns (sender's monotonic clock) | payload length u16 | flags u16
+followed by the payload. Flag bit 0 marks a retransmission.
+
+The server acknowledges a message with an ACK header (no payload) carrying
+the same sequence number and send time, from which Kria measures the RTT.
+
+Commands sent together arrive as one BATCH: binary, a header with sequence
+0 and a payload of u16 count followed by the complete messages; text,
+"BATCH:<count>" followed by the commands, one per line. The commands in a
+batch are acknowledged one by one; the batch itself is not.
+
+Telemetry goes the other way: a SCAN carries u16 count, then per point u16
+distance in millimeters and u16 angle in hundredths of a degree, at most
+MAX_SCAN_POINTS points. Scans are not acknowledged.
+"""
+
+import struct
+import time
+
+MAGIC = 0x4B43
+VERSION = 1
+HEADER = struct.Struct(">HBBIqHH")
+HEADER_SIZE = HEADER.size
+
+BUTTON, TOUCH, MODE, ACK, STATE, BATCH, STOP, SCAN = 1, 2, 3, 4, 5, 6, 7, 8
+MAX_SCAN_POINTS = 360
+RETRANSMIT_FLAG = 0x0001
+# Receive buffer for one datagram, ControlLink::MaxDatagramSize; batches
+# reach 1222 bytes
+MAX_DATAGRAM_SIZE = 2048
+BUTTON_NAMES = {1: "UP", 2: "DOWN", 3: "LEFT", 4: "RIGHT"}
+DIRECTION_BITS = ((0x01, "UP"), (0x02, "DOWN"), (0x04, "LEFT"), (0x08, "RIGHT"))
+STATE_EDGE_FLAG = 0x01
+
+
+def state_command(directions, x, y):
+    """Text form of a STATE message, as sent with --control-protocol text"""
+    names = "+".join(name for bit, name in DIRECTION_BITS if directions & bit) or "NONE"
+    return f"STATE:{names}:{x / 32767:.3f}:{y / 32767:.3f}"
+
+
+def is_binary(data):
+    """True if data starts with a binary control message"""
+    return len(data) >= 2 and struct.unpack_from(">H", data)[0] == MAGIC
+
+
+def decode(data, offset=0):
+    """Decodes one message at offset.
+
+    Returns (message dict, bytes consumed), or (None, 0) if data doesn't hold
+    a complete message yet. Raises ValueError on a malformed header.
+    """
+    if len(data) - offset < HEADER_SIZE:
+        return None, 0
+    magic, version, msg_type, sequence, sent_ns, length, flags = HEADER.unpack_from(data, offset)
+    if magic != MAGIC:
+        raise ValueError(f"bad magic 0x{magic:04X}")
+    if version != VERSION:
+        raise ValueError(f"unsupported version {version}")
+    end = offset + HEADER_SIZE + length
+    if len(data) < end:
+        return None, 0
+
+    payload = bytes(data[offset + HEADER_SIZE:end])
+    message = {"type": msg_type, "sequence": sequence, "sent_ns": sent_ns,
+               "retransmit": bool(flags & RETRANSMIT_FLAG)}
+    if msg_type == BUTTON and length >= 1:
+        message["command"] = f"BUTTON:{BUTTON_NAMES.get(payload[0], payload[0])}"
+    elif msg_type == TOUCH and length >= 8:
+        x, y = struct.unpack(">ii", payload[:8])
+        message["command"] = f"TOUCH:{x}:{y}"
+    elif msg_type == MODE and length >= 1:
+        message["command"] = f"MODE:{'AUTO' if payload[0] else 'MANUAL'}"
+    elif msg_type == STATE and length >= 6:
+        directions, state_flags, x, y = struct.unpack(">BBhh", payload[:6])
+        message["command"] = state_command(directions, x, y)
+        message["edge"] = bool(state_flags & STATE_EDGE_FLAG)
+    elif msg_type == BATCH and length >= 2:
+        count = struct.unpack(">H", payload[:2])[0]
+        message["messages"] = []
+        position = 2
+        for _ in range(count):
+            inner, size = decode(payload, position)
+            if inner is None:
+                raise ValueError("truncated batch")
+            message["messages"].append(inner)
+            position += size
+        message["command"] = f"BATCH:{count}"
+    elif msg_type == STOP:
+        message["command"] = "STOP"
+    elif msg_type == SCAN and length >= 2:
+        count = struct.unpack(">H", payload[:2])[0]
+        message["points"] = [(distance / 1000.0, angle / 100.0) for distance, angle
+                             in struct.iter_unpack(">HH", payload[2:2 + count * 4])]
+        message["command"] = f"SCAN:{count}"
+    elif msg_type == ACK:
+        message["command"] = "ACK"
+    else:
+        message["command"] = f"TYPE{msg_type}:{payload.hex()}"
+    return message, end - offset
+
+
+def unpack(message):
+    """The messages of a decoded batch, or the message itself"""
+    return message.get("messages", [message])
+
+
+def split_text(text):
+    """The commands of a text datagram: one, or those of a BATCH"""
+    lines = text.split("\n")
+    if lines[0].startswith("BATCH:"):
+        count = int(lines[0].split(":", 1)[1])
+        return [line for line in lines[1:count + 1]]
+    return [text]
+
+
+def encode_batch(messages, sent_ns=None):
+    """Packs encoded messages into a batch, e.g. for a test client"""
+    payload = struct.pack(">H", len(messages)) + b"".join(messages)
+    return encode(BATCH, 0, payload, sent_ns)
+
+
+def encode(msg_type, sequence, payload, sent_ns=None, flags=0):
+    """Encodes a message, e.g. for a test client"""
+    if sent_ns is None:
+        sent_ns = time.monotonic_ns()
+    return HEADER.pack(MAGIC, VERSION, msg_type, sequence, sent_ns, len(payload), flags) + payload
+
+
+def encode_scan(sequence, points, sent_ns=None):
+    """SCAN message from (distance m, angle degrees) pairs"""
+    if len(points) > MAX_SCAN_POINTS:
+        raise ValueError(f"at most {MAX_SCAN_POINTS} points per scan")
+    payload = struct.pack(">H", len(points)) + b"".join(
+        struct.pack(">HH", min(int(round(distance * 1000)), 0xFFFF),
+                    max(0, min(int(round(angle * 100)), 18000)))
+        for distance, angle in points)
+    return encode(SCAN, sequence, payload, sent_ns)
+
+
+def encode_ack(message):
+    """ACK for a decoded message: same sequence number, send time echoed"""
+    return encode(ACK, message["sequence"], b"", message["sent_ns"])
+
+
+class SequenceTracker:
+    """Loss, reorder and one-way delay variation of one sender's messages
+
+    The sender's clock is unrelated to ours, so the absolute one-way delay is
+    unknown; relative to the fastest message seen it still shows queueing and
+    jitter.
+    """
+
+    def __init__(self):
+        self.received = 0
+        self.lost = 0
+        self.reordered = 0
+        self.duplicates = 0
+        self.highest = None
+        self.min_offset = None
+        self.last_delay_ms = 0.0
+
+    def update(self, message, received_ns=None):
+        if received_ns is None:
+            received_ns = time.monotonic_ns()
+        sequence = message["sequence"]
+        self.received += 1
+
+        if self.highest is None or sequence == self.highest + 1:
+            self.highest = sequence
+        elif sequence > self.highest:
+            self.lost += sequence - self.highest - 1
+            self.highest = sequence
+        elif sequence == self.highest:
+            self.duplicates += 1
+        else:
+            # Late arrival of one we counted as lost
+            self.reordered += 1
+            self.lost = max(0, self.lost - 1)
+
+        offset = received_ns - message["sent_ns"]
+        if self.min_offset is None or offset < self.min_offset:
+            self.min_offset = offset
+        self.last_delay_ms = (offset - self.min_offset) / 1e6
+        return self.last_delay_ms
+
+    def summary(self):
+        return (f"received {self.received}, lost {self.lost}, reordered {self.reordered}, "
+                f"duplicates {self.duplicates}, delay +{self.last_delay_ms:.2f} ms")
@@ -6,6 +6,8 @@ Debug UDP listener to check if Kria is sending commands
 import socket
 import sys
 
+import control_protocol
+
 def debug_udp_listener(host='0.0.0.0', port=8556):
     """Simple UDP listener with verbose output"""
     
@@ -26,8 +28,21 @@ def debug_udp_listener(host='0.0.0.0', port=8556):
             try:
                 # Receive data with longer timeout
                 sock.settimeout(1.0)
-                data, addr = sock.recvfrom(1024)
+                data, addr = sock.recvfrom(control_protocol.MAX_DATAGRAM_SIZE)
                 
+                # Binary control protocol (--control-protocol binary)
+                if control_protocol.is_binary(data):
+                    print(f"📦 FROM {addr[0]}:{addr[1]} (Binary control message)")
+                    print(f"   Raw bytes: {data.hex()}")
+                    print(f"   Length   : {len(data)} bytes")
+                    try:
+                        message, _ = control_protocol.decode(data)
+                        print(f"   Decoded  : {message}")
+                    except ValueError as e:
+                        print(f"   Malformed: {e}")
+                    print("-" * 40)
+                    continue
+
                 # Decode and display
                 try:
                     message = data.decode('utf-8')
@@ -36,10 +51,11 @@ def debug_udp_listener(host='0.0.0.0', port=8556):
                     print(f"   Decoded  : '{message}'")
                     print(f"   Length   : {len(data)} bytes")
                     
-                    # Send acknowledgment
-                    ack = f"ACK:{message}"
-                    sock.sendto(ack.encode('utf-8'), addr)
-                    print(f"   ✓ Sent ACK: {ack}")
+                    # Send acknowledgment, one per command of a batch
+                    for command in control_protocol.split_text(message):
+                        ack = f"ACK:{command}"
+                        sock.sendto(ack.encode('utf-8'), addr)
+                        print(f"   ✓ Sent ACK: {ack}")
                     
                 except UnicodeDecodeError:
                     print(f"📦 FROM {addr[0]}:{addr[1]} (Binary data)")
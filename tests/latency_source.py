@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+Timestamp-stamped video source for glass-to-glass latency tests
+Generates frames with a block-coded wall-clock timestamp and frame counter
+in the centre, encodes them with ffmpeg and streams them on loopback.
+Run Kria with --latency-probe to decode the stamp from the painted frames.
+
+Stamp layout (must match src/latencyprobe.cpp):
+  8x8 grid of square cells centred in the frame, cell size min(w, h) // 16
+  64 bits, row by row, most significant bit first; white = 1, black = 0
+    bits 63..56  sync pattern 0xB2
+    bits 55..16  wall clock time in milliseconds, modulo 2^40
+    bits 15..0   frame counter, modulo 2^16
+"""
+
+import argparse
+import subprocess
+import sys
+import time
+
+SYNC = 0xB2
+GRID = 8
+WHITE = 235
+BLACK = 16
+BACKGROUND = 64
+
+
+def stamp_bits(timestamp_ms, counter):
+    """Pack sync, timestamp and counter into the 64 stamp bits"""
+    return (SYNC << 56) | ((timestamp_ms & ((1 << 40) - 1)) << 16) | (counter & 0xFFFF)
+
+
+def fill_rect(frame, width, x, y, w, h, value):
+    """Fill a rectangle of a BGR24 frame with a gray value"""
+    row = bytes([value]) * (w * 3)
+    for line in range(y, y + h):
+        start = (line * width + x) * 3
+        frame[start:start + w * 3] = row
+
+
+def render_frame(base, width, height, timestamp_ms, counter):
+    """Copy the background, draw a moving bar and the stamp"""
+    frame = bytearray(base)
+
+    # Moving bar so the encoder sees motion, away from the stamp
+    bar_x = (counter * 8) % max(1, width - 32)
+    fill_rect(frame, width, bar_x, 0, 32, height // 8, 200)
+
+    cell = min(width, height) // 16
+    x0 = (width - GRID * cell) // 2
+    y0 = (height - GRID * cell) // 2
+    bits = stamp_bits(timestamp_ms, counter)
+    for i in range(GRID * GRID):
+        bit = (bits >> (63 - i)) & 1
+        row, col = divmod(i, GRID)
+        fill_rect(frame, width, x0 + col * cell, y0 + row * cell, cell, cell,
+                  WHITE if bit else BLACK)
+    return frame
+
+
+def ffmpeg_command(args):
+    """ffmpeg reading raw BGR frames from stdin and streaming with low latency"""
+    command = [
+        "ffmpeg", "-hide_banner", "-loglevel", "warning",
+        "-f", "rawvideo", "-pix_fmt", "bgr24",
+        "-s", f"{args.width}x{args.height}", "-r", str(args.fps), "-i", "-",
+        "-c:v", "libx264", "-preset", "ultrafast", "-tune", "zerolatency",
+        "-g", str(args.fps), "-pix_fmt", "yuv420p",
+    ]
+    if args.output.startswith("rtsp://"):
+        # Needs an RTSP server (e.g. mediamtx) listening at that address
+        command += ["-f", "rtsp", "-rtsp_transport", "tcp", args.output]
+    else:
+        command += ["-f", "mpegts", args.output]
+    return command
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Timestamp-stamped stream for Kria latency tests")
+    parser.add_argument("--width", type=int, default=1280)
+    parser.add_argument("--height", type=int, default=720)
+    parser.add_argument("--fps", type=int, default=30)
+    parser.add_argument("--output", default="udp://127.0.0.1:5000?pkt_size=1316",
+                        help="ffmpeg output URL: udp://... (MPEG-TS, default) or rtsp://... "
+                             "(publish to an RTSP server)")
+    parser.add_argument("--duration", type=float, default=0,
+                        help="Stop after this many seconds (default: run until Ctrl+C)")
+    args = parser.parse_args()
+
+    base = bytearray(bytes([BACKGROUND]) * (args.width * args.height * 3))
+    print(f"Streaming {args.width}x{args.height}@{args.fps} to {args.output}")
+    print(f"Run: kria --latency-probe \"{args.output.split('?')[0]}\"")
+
+    try:
+        encoder = subprocess.Popen(ffmpeg_command(args), stdin=subprocess.PIPE)
+    except FileNotFoundError:
+        print("ffmpeg not found in PATH", file=sys.stderr)
+        sys.exit(1)
+
+    period = 1.0 / args.fps
+    start = time.monotonic()
+    next_frame = start
+    counter = 0
+
+    try:
+        while args.duration <= 0 or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+            if next_frame > now:
+                time.sleep(next_frame - now)
+            next_frame += period
+
+            # Stamp with the wall clock right before handing the frame over,
+            # the client compares against its own wall clock
+            timestamp_ms = int(time.time() * 1000)
+            encoder.stdin.write(render_frame(base, args.width, args.height, timestamp_ms, counter))
+            encoder.stdin.flush()
+            counter += 1
+
+            if counter % (args.fps * 10) == 0:
+                print(f"{counter} frames sent")
+
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+    finally:
+        print(f"\nStopped after {counter} frames")
+        try:
+            encoder.stdin.close()
+        except BrokenPipeError:
+            pass
+        encoder.wait()
+
+
+if __name__ == "__main__":
+    main()
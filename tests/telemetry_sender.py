@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Stand-in for the robot's radar/LiDAR telemetry
+Streams synthetic SCAN messages (see control_protocol.py) to Kria: a wall
+at a fixed range with an obstacle sweeping back and forth in front of it.
+
+UDP (default) sends to Kria's telemetry port:
+  kria --telemetry-port 8557
+  ./telemetry_sender.py --udp 127.0.0.1:8557
+
+TCP listens in place of the control server and streams to the client
+once it connects, reading and discarding its commands:
+  ./telemetry_sender.py --tcp-listen 8555
+"""
+
+import argparse
+import math
+import socket
+import sys
+import time
+
+import control_protocol
+
+
+def make_scan(points, t):
+    """(distance m, angle degrees) pairs for time t in seconds"""
+    obstacle_angle = 90 + 70 * math.sin(t * 0.5)
+    obstacle_distance = 2.5 + 1.5 * math.sin(t * 0.23)
+    scan = []
+    for i in range(points):
+        angle = 180.0 * i / max(points - 1, 1)
+        distance = 8.0
+        if abs(angle - obstacle_angle) < 10:
+            distance = obstacle_distance
+        scan.append((distance, angle))
+    return scan
+
+
+def parse_address(text):
+    host, _, port = text.rpartition(":")
+    return host or "127.0.0.1", int(port)
+
+
+def accept_client(port):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("0.0.0.0", port))
+    server.listen(1)
+    print(f"Waiting for Kria on TCP port {port}")
+    client, address = server.accept()
+    server.close()
+    client.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    client.setblocking(False)
+    print(f"Streaming to {address[0]}:{address[1]}")
+    return client
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Synthetic radar scans for Kria telemetry tests")
+    parser.add_argument("--udp", default="127.0.0.1:8557", metavar="HOST:PORT",
+                        help="Send scans to this address (default 127.0.0.1:8557)")
+    parser.add_argument("--tcp-listen", type=int, metavar="PORT",
+                        help="Accept Kria's control connection on PORT and send scans over it instead")
+    parser.add_argument("--rate", type=float, default=10, help="Scans per second (default 10)")
+    parser.add_argument("--points", type=int, default=181,
+                        help=f"Points per scan, at most {control_protocol.MAX_SCAN_POINTS} (default 181)")
+    parser.add_argument("--duration", type=float, default=0,
+                        help="Stop after this many seconds (default: run until Ctrl+C)")
+    args = parser.parse_args()
+
+    if not 0 < args.points <= control_protocol.MAX_SCAN_POINTS:
+        parser.error(f"--points must be 1..{control_protocol.MAX_SCAN_POINTS}")
+
+    if args.tcp_listen:
+        client = accept_client(args.tcp_listen)
+        udp = None
+    else:
+        client = None
+        udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        target = parse_address(args.udp)
+        print(f"Sending {args.points}-point scans at {args.rate}/s to {target[0]}:{target[1]}")
+
+    period = 1.0 / args.rate
+    start = time.monotonic()
+    next_scan = start
+    sequence = 0
+
+    try:
+        while args.duration <= 0 or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+            if next_scan > now:
+                time.sleep(next_scan - now)
+            next_scan += period
+
+            sequence += 1
+            message = control_protocol.encode_scan(sequence, make_scan(args.points, now - start))
+            if client:
+                try:
+                    if not client.recv(4096):  # Commands from Kria, not needed here
+                        break
+                except BlockingIOError:
+                    pass
+                client.setblocking(True)
+                client.sendall(message)
+                client.setblocking(False)
+            else:
+                udp.sendto(message, target)
+
+            if sequence % int(max(args.rate, 1) * 10) == 0:
+                print(f"{sequence} scans sent")
+
+    except (KeyboardInterrupt, BrokenPipeError, ConnectionResetError):
+        pass
+    finally:
+        print(f"\nStopped after {sequence} scans")
+        if client:
+            client.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
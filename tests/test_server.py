@@ -4,13 +4,40 @@ Simple test server for the Kria Native Controller CLIENT
 Receives UDP commands and TCP connections from Kria app
 """
 
+import random
 import socket
 import threading
 import time
 import sys
 
-def udp_server(host='0.0.0.0', port=8556):
-    """UDP server to receive commands from Kria client"""
+import control_protocol
+
+def print_command(command):
+    """Describes a text command"""
+    if command.startswith("BUTTON:"):
+        button = command.split(":", 1)[1]
+        print(f"  -> Button pressed: {button}")
+    elif command.startswith("TOUCH:"):
+        parts = command.split(":")
+        if len(parts) >= 3:
+            x, y = parts[1], parts[2]
+            print(f"  -> Touch coordinate: ({x}, {y})")
+    elif command.startswith("MODE:"):
+        mode = command.split(":", 1)[1]
+        print(f"  -> Mode changed: {mode}")
+    elif command == "STOP":
+        print("  -> EMERGENCY STOP")
+    elif command.startswith("STATE:"):
+        parts = command.split(":")
+        if len(parts) >= 4:
+            print(f"  -> Held: {parts[1]}, stick ({parts[2]}, {parts[3]})")
+
+def udp_server(host='0.0.0.0', port=8556, loss=0.0):
+    """UDP server to receive commands from Kria client
+
+    loss is the fraction of datagrams dropped unanswered, to exercise
+    Kria's retransmission.
+    """
     
     print(f"Starting UDP server on {host}:{port}")
     
@@ -21,31 +48,54 @@ def udp_server(host='0.0.0.0', port=8556):
     print("UDP server listening for Kria commands...")
     print("=" * 50)
     
+    trackers = {}
     try:
         while True:
             # Receive data
-            data, addr = sock.recvfrom(1024)
-            command = data.decode('utf-8')
+            data, addr = sock.recvfrom(control_protocol.MAX_DATAGRAM_SIZE)
             timestamp = time.strftime("%H:%M:%S")
-            
-            print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> {command}")
-            
-            # Parse command
-            if command.startswith("BUTTON:"):
-                button = command.split(":", 1)[1]
-                print(f"  -> Button pressed: {button}")
-            elif command.startswith("TOUCH:"):
-                parts = command.split(":")
-                if len(parts) >= 3:
-                    x, y = parts[1], parts[2]
-                    print(f"  -> Touch coordinate: ({x}, {y})")
-            elif command.startswith("MODE:"):
-                mode = command.split(":", 1)[1]
-                print(f"  -> Mode changed: {mode}")
-            
-            # Send acknowledgment
-            ack = f"ACK:{command}"
-            sock.sendto(ack.encode('utf-8'), addr)
+
+            if loss > 0 and random.random() < loss:
+                print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> dropped (simulated loss)")
+                continue
+
+            if control_protocol.is_binary(data):
+                # Binary protocol: report sequence gaps and delay variation
+                try:
+                    message, _ = control_protocol.decode(data)
+                except ValueError as e:
+                    print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> malformed binary message: {e}")
+                    continue
+                if message is None:
+                    print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> truncated binary message")
+                    continue
+                messages = control_protocol.unpack(message)
+                if len(messages) > 1 or message["type"] == control_protocol.BATCH:
+                    print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> batch of {len(messages)}")
+                tracker = trackers.setdefault(addr, control_protocol.SequenceTracker())
+                for message in messages:
+                    tracker.update(message)
+                    command = message["command"]
+                    resent = " (retransmission)" if message["retransmit"] else ""
+                    if message.get("edge"):
+                        resent += " (edge)"
+                    print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> #{message['sequence']} {command}{resent} "
+                          f"({tracker.summary()})")
+
+                    # Echo the header back so Kria can match it and measure the RTT
+                    sock.sendto(control_protocol.encode_ack(message), addr)
+                continue
+
+            commands = control_protocol.split_text(data.decode('utf-8'))
+            if len(commands) > 1 or data.startswith(b"BATCH:"):
+                print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> batch of {len(commands)}")
+            for command in commands:
+                print(f"[{timestamp}] FROM {addr[0]}:{addr[1]} -> {command}")
+                print_command(command)
+
+                # Send acknowledgment
+                ack = f"ACK:{command}"
+                sock.sendto(ack.encode('utf-8'), addr)
             
     except KeyboardInterrupt:
         print("\nUDP server stopped")
@@ -73,13 +123,39 @@ def tcp_server(host='0.0.0.0', port=8555):
         welcome = "WELCOME:Kria Test Server\n"
         client_sock.send(welcome.encode('utf-8'))
         
+        buffer = bytearray()
+        tracker = control_protocol.SequenceTracker()
         try:
             while True:
                 data = client_sock.recv(1024)
                 if not data:
                     break
-                
-                commands = data.decode('utf-8').strip().split('\n')
+                buffer += data
+
+                # Binary messages are length-prefixed, text commands newline terminated
+                commands = []
+                while buffer:
+                    if control_protocol.is_binary(buffer):
+                        message, size = control_protocol.decode(buffer)
+                        if message is None:
+                            break
+                        del buffer[:size]
+                        for message in control_protocol.unpack(message):
+                            delay = tracker.update(message)
+                            commands.append(f"#{message['sequence']} {message['command']} "
+                                            f"(delay +{delay:.2f} ms, lost {tracker.lost})")
+                    else:
+                        end = buffer.find(b'\n')
+                        if end < 0:
+                            break
+                        line = buffer[:end].decode('utf-8').strip()
+                        del buffer[:end + 1]
+                        # The commands of a text batch follow on their own lines
+                        if line.startswith("BATCH:"):
+                            print(f"[{time.strftime('%H:%M:%S')}] TCP FROM {addr[0]} -> batch of {line[6:]}")
+                            continue
+                        commands.append(line)
+
                 for command in commands:
                     if command:
                         timestamp = time.strftime("%H:%M:%S")
@@ -118,6 +194,11 @@ def print_help():
     print("  BUTTON:UP, BUTTON:DOWN, BUTTON:LEFT, BUTTON:RIGHT")
     print("  TOUCH:x:y (coordinates from AUTO mode)")
     print("  MODE:AUTO, MODE:MANUAL")
+    print("  STATE:UP+LEFT:x:y (held directions and stick, sent at --input-rate while held)")
+    print("  STOP (emergency stop, also sent over TCP)")
+    print("  BATCH:n followed by n commands, one per line (sent together)")
+    print("Binary messages (--control-protocol binary) are decoded as well,")
+    print("with sequence gaps, reordering and delay variation reported.")
     print()
     print("Usage:")
     print("  python3 test_server.py [--udp-only] [--tcp-only] [--help]")
@@ -125,6 +206,7 @@ def print_help():
     print("Options:")
     print("  --udp-only    Start only UDP server")
     print("  --tcp-only    Start only TCP server")
+    print("  --loss <p>    Drop this fraction of UDP datagrams unanswered (e.g. 0.2)")
     print("  --help        Show this help")
     print()
 
@@ -135,6 +217,9 @@ if __name__ == "__main__":
     
     udp_only = "--udp-only" in sys.argv
     tcp_only = "--tcp-only" in sys.argv
+    loss = 0.0
+    if "--loss" in sys.argv:
+        loss = float(sys.argv[sys.argv.index("--loss") + 1])
     
     print("Kria Test Server")
     print("Waiting for commands from Kria CLIENT application...")
@@ -146,7 +231,7 @@ if __name__ == "__main__":
     try:
         if not tcp_only:
             # Start UDP server in a thread
-            udp_thread = threading.Thread(target=udp_server)
+            udp_thread = threading.Thread(target=udp_server, kwargs={"loss": loss})
             udp_thread.daemon = True
             udp_thread.start()
             threads.append(udp_thread)